@@ -0,0 +1,154 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "redfa.h"
+#include "structures.h"
+#include "nfa.h"
+#include "ast.h"
+#include "dfa.h"
+#include "parse.h"
+#include "dict.h"
+#include "table.h"
+#include "sheng.h"
+#include "search.h"
+#include "stream.h"
+
+//redfa Library Functions
+//-----------------------
+
+struct redfa
+{
+    dfa *D;
+    compactTable *T;
+    shengTable *K;
+    searcher *S;
+};
+
+_Static_assert(sizeof(redfaStream) == sizeof(matchStream), "redfaStream must mirror matchStream");
+
+static dfa *compileDfa(const char *regex, int *error)
+{
+    size_t n = strlen(regex);
+    char *input = strdup(regex);
+    char *inputDot = malloc(2 * n + 2), *inputNPR = malloc(2 * n + 2);
+    dfa *D = NULL, *Dmin = NULL;
+    astTable *A = newAstTable();
+    astNode *root;
+    nfa *N;
+    addDot(input, inputDot);
+    if ((*error = convert(inputDot, inputNPR)) == PARSE_OK)
+    {
+        if (literalAlternation(input))
+        {
+            int nWords;
+            char **words = splitAlternation(input, &nWords);
+            Dmin = buildDictionary(words, nWords);
+            free(words[0]);
+            free(words);
+        }
+        else if ((root = buildAst(A, inputNPR)))
+        {
+            N = astToReducedNfa(A, root);
+            D = nfaToDfa(N);
+            Dmin = minimize(D);
+            disposeNfaAutomata(N);
+            disposeDfaAutomata(D);
+        }
+        else
+            *error = PARSE_OPERAND;
+    }
+    disposeAstTable(A);
+    free(input);
+    free(inputDot);
+    free(inputNPR);
+    return Dmin;
+}
+
+redfa *redfaCompile(const char *regex, int flags, int *error)
+{
+    redfa *R;
+    int e;
+    dfa *D = compileDfa(regex, &e);
+    if (error)
+        *error = e;
+    if (!D)
+        return NULL;
+    R = malloc(sizeof(redfa));
+    R->D = D;
+    R->T = buildCompactTable(D);
+    R->K = buildShengTable(R->T);
+    R->S = flags & REDFA_SEARCH ? buildSearcher(D) : NULL;
+    return R;
+}
+
+const char *redfaError(int error)
+{
+    return parseError(error);
+}
+
+void redfaFree(redfa *R)
+{
+    if (!R) return;
+    disposeShengTable(R->K);
+    disposeCompactTable(R->T);
+    disposeSearcher(R->S);
+    disposeDfaAutomata(R->D);
+    free(R);
+}
+
+int redfaMatch(const redfa *R, const char *input, size_t size)
+{
+    if (R->K)
+        return matchShengTable(R->K, input, size);
+    return matchCompactTable(R->T, input, size);
+}
+
+void redfaMatchBatch(const redfa *R, const char **inputs, const size_t *sizes, int n, int *results)
+{
+    int i;
+    if (R->K)
+        for (i = 0; i < n; i++)
+            results[i] = matchShengTable(R->K, inputs[i], sizes[i]);
+    else
+        matchCompactTableBatch(R->T, inputs, sizes, n, results);
+}
+
+int redfaSearch(const redfa *R, const char *input, size_t size, size_t pos, size_t *start, size_t *end)
+{
+    if (!R->S)
+        return -1;
+    return nextMatch(R->S, input, size, pos, start, end);
+}
+
+void redfaStreamInit(const redfa *R, redfaStream *st)
+{
+    initMatchStream((matchStream *)st, R->T);
+}
+
+void redfaStreamFeed(const redfa *R, redfaStream *st, const char *input, size_t size)
+{
+    feedMatchStream((matchStream *)st, R->T, input, size);
+}
+
+int redfaStreamAccept(const redfa *R, const redfaStream *st)
+{
+    return acceptMatchStream((matchStream *)st, R->T);
+}
@@ -0,0 +1,237 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "ast.h"
+#include "nfa.h"
+#include "stack.h"
+
+//Regex AST Functions
+//-------------------
+//  Nodes are interned by (op, left, right): an equal subtree, inside a
+//  regex or across the rules of a lexer, is one node, whose nfa
+//  fragment is built once. Rewrites applied while interning:
+//    (x*)* -> x*       x|x -> x       x|x* -> x*       x*x* -> x*
+//  and the operands of | are ordered by node id, so a|b = b|a
+
+astTable *newAstTable(void)
+{
+    astTable *A = malloc(sizeof(astTable));
+    A->nNodes = 0;
+    A->nBuckets = 256;
+    A->buckets = calloc(A->nBuckets, sizeof(astNode *));
+    A->shared = 0;
+    return A;
+}
+
+static unsigned hashNode(char op, astNode *left, astNode *right)
+{
+    unsigned h = (unsigned char)op * 2654435761u;
+    h = (h ^ (left ? left->id + 1 : 0)) * 16777619u;
+    h = (h ^ (right ? right->id + 1 : 0)) * 16777619u;
+    return h ^ h >> 16;
+}
+
+static void growAstTable(astTable *A)
+{
+    astNode **buckets = calloc(2 * A->nBuckets, sizeof(astNode *));
+    int i;
+    for (i = 0; i < A->nBuckets; i++)
+        while (A->buckets[i])
+        {
+            astNode *n = A->buckets[i];
+            unsigned h = hashNode(n->op, n->left, n->right) & (2 * A->nBuckets - 1);
+            A->buckets[i] = n->next;
+            n->next = buckets[h];
+            buckets[h] = n;
+        }
+    free(A->buckets);
+    A->buckets = buckets;
+    A->nBuckets *= 2;
+}
+
+static astNode *internNode(astTable *A, char op, astNode *left, astNode *right)
+{
+    unsigned h = hashNode(op, left, right) & (A->nBuckets - 1);
+    astNode *n;
+    for (n = A->buckets[h]; n; n = n->next)
+        if (n->op == op && n->left == left && n->right == right)
+        {
+            A->shared++;
+            return n;
+        }
+    n = malloc(sizeof(astNode));
+    n->op = op;
+    n->id = A->nNodes++;
+    n->refs = 0;
+    n->left = left;
+    n->right = right;
+    n->fragment = NULL;
+    n->next = A->buckets[h];
+    A->buckets[h] = n;
+    if (left)
+        left->refs++;
+    if (right)
+        right->refs++;
+    if (A->nNodes > 2 * A->nBuckets)
+        growAstTable(A);
+    return n;
+}
+
+static astNode *kleeneNode(astTable *A, astNode *x)
+{
+    if (x->op == '*')
+        return x;
+    return internNode(A, '*', x, NULL);
+}
+
+static astNode *unionNode(astTable *A, astNode *x, astNode *y)
+{
+    if (x == y || (y->op == '*' && y->left == x))
+        return y;
+    if (x->op == '*' && x->left == y)
+        return x;
+    return x->id < y->id ? internNode(A, '|', x, y) : internNode(A, '|', y, x);
+}
+
+static astNode *concatNode(astTable *A, astNode *x, astNode *y)
+{
+    if (x == y && x->op == '*')
+        return x;
+    return internNode(A, '.', x, y);
+}
+
+// tree of a postfix regex (NULL if an operand is missing)
+astNode *buildAst(astTable *A, char *postfix)
+{
+    stack P = NULL;
+    astNode *x, *y;
+    int i;
+    for (i = 0; postfix[i]; i++)
+    {
+        char c = tolower(postfix[i]);
+        if (isAlphabet(c))
+            push(&P, internNode(A, c, NULL, NULL));
+        else if ((c == '*' || c == '.' || c == '|') && (!P || (c != '*' && !P->next)))
+            break; // missing operand
+        else if (c == '*')
+            push(&P, kleeneNode(A, pop(&P)));
+        else if (c == '.' || c == '|')
+        {
+            y = pop(&P);
+            x = pop(&P);
+            push(&P, c == '.' ? concatNode(A, x, y) : unionNode(A, x, y));
+        }
+    }
+    x = !postfix[i] && P && !P->next ? pop(&P) : NULL;
+    while (P)
+        pop(&P);
+    if (x)
+        x->refs++; // used as a root
+    return x;
+}
+
+static nfa *copyNfa(nfa *N)
+{
+    nfa *M = malloc(sizeof(nfa));
+    int i;
+    M->nStates = N->nStates;
+    M->transitions = malloc(N->nStates * sizeof(link *));
+    for (i = 0; i < N->nStates; i++)
+    {
+        link *L, **tail = M->transitions + i;
+        for (L = N->transitions[i]; L; L = L->next)
+        {
+            *tail = malloc(sizeof(link));
+            (*tail)->symbol = L->symbol;
+            (*tail)->state = L->state;
+            tail = &(*tail)->next;
+        }
+        *tail = NULL;
+    }
+    return M;
+}
+
+// Thompson nfa of the subtree; shared nodes keep theirs for reuse.
+// Postorder with an explicit stack of nodes (as regexToNfa): a node is
+// pushed under a NULL mark, above which its operands are pushed, so it
+// is popped after the mark to join their nfas (on the stack F)
+nfa *astToNfa(astTable *A, astNode *x)
+{
+    stack P = NULL, F = NULL;
+    nfa *N, *L, *R;
+    push(&P, x);
+    while (P)
+    {
+        x = pop(&P);
+        if (x && x->fragment)
+        {
+            push(&F, copyNfa(x->fragment));
+            continue;
+        }
+        if (x && x->left)
+        {
+            push(&P, x);
+            push(&P, NULL);
+            if (x->op != '*')
+                push(&P, x->right);
+            push(&P, x->left);
+            continue;
+        }
+        if (x)
+            N = buildSymbol(x->op);
+        else
+        {
+            // mark: the operands of the node under it are built
+            x = pop(&P);
+            R = x->op == '*' ? NULL : pop(&F);
+            L = pop(&F);
+            if (x->op == '*')
+                N = buildKleene(L);
+            else
+                N = x->op == '.' ? buildConcat(L, R) : buildUnion(L, R);
+            disposeNfaAutomata(L);
+            disposeNfaAutomata(R);
+        }
+        if (x->refs > 1)
+        {
+            x->fragment = N;
+            N = copyNfa(N);
+        }
+        push(&F, N);
+    }
+    return pop(&F);
+}
+
+void disposeAstTable(astTable *A)
+{
+    int i;
+    if (!A) return;
+    for (i = 0; i < A->nBuckets; i++)
+        while (A->buckets[i])
+        {
+            astNode *n = A->buckets[i];
+            A->buckets[i] = n->next;
+            disposeNfaAutomata(n->fragment);
+            free(n);
+        }
+    free(A->buckets);
+    free(A);
+}
@@ -0,0 +1,12 @@
+#ifndef __AST__
+#define __AST__
+#include "structures.h"
+
+//Regex AST Functions
+//-------------------
+astTable *newAstTable(void);
+astNode *buildAst(astTable *, char *);
+nfa *astToNfa(astTable *, astNode *);
+void disposeAstTable(astTable *);
+
+#endif
@@ -0,0 +1,92 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// Searcher scans with and without the acceleration of exit states
+// Usage: bench/accel [MB] [repetitions]
+// Text: lines of random [a-z0-9] words. Patterns whose first byte is
+// rare get exit states (skipped with SIMD), the others must not lose
+
+#include <time.h>
+#include "structures.h"
+#include "nfa.h"
+#include "dfa.h"
+#include "parse.h"
+#include "search.h"
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// best of the repetitions, in MB/s
+static double measure(searcher *S, char *buffer, size_t size, int repeat, long *matches)
+{
+    double best = 1e30;
+    int r;
+    for (r = 0; r < repeat; r++)
+    {
+        size_t pos = 0, start, end;
+        double t = now();
+        for (*matches = 0; nextMatch(S, buffer, size, pos, &start, &end); pos = end)
+            (*matches)++;
+        t = now() - t;
+        if (t < best)
+            best = t;
+    }
+    return size / best / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    char *regexes[] = {"error", "zq(a|b)", "(a|b)*abb", "get|put|post|delete", "x(0|1)(0|1)", "(j|k)(0|1)",
+                       "(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)", NULL};
+    size_t size = (argc > 1 ? atol(argv[1]) : 32) << 20, j;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    char *buffer = malloc(size);
+    int i;
+    srand(1);
+    for (j = 0; j < size; j++)
+        buffer[j] = rand() % 8 ? "abcdefghijklmnopqrstuvwxyz0123456789"[rand() % 36] : rand() % 2 ? ' ' : '\n';
+    printf("%-28s %6s %12s %12s %8s %8s\n", "regex", "accel", "plain", "accel", "speedup", "matches");
+    for (i = 0; regexes[i]; i++)
+    {
+        nfa *N = parseRegex(regexes[i]);
+        dfa *D = nfaToDfa(N), *Dmin = minimize(D);
+        searcher *S = buildSearcher(Dmin);
+        int nAccel = S->F->nAccel;
+        long plainMatches, accelMatches;
+        double plain, accel;
+        S->F->nAccel = 0;
+        plain = measure(S, buffer, size, repeat, &plainMatches);
+        S->F->nAccel = nAccel;
+        accel = measure(S, buffer, size, repeat, &accelMatches);
+        printf("%-28.28s %6d %7.0f MB/s %7.0f MB/s %7.2fx %8ld%s\n", regexes[i], nAccel, plain, accel, accel / plain,
+               accelMatches, accelMatches == plainMatches ? "" : " (differ)");
+        disposeSearcher(S);
+        disposeNfaAutomata(N);
+        disposeDfaAutomata(D);
+        disposeDfaAutomata(Dmin);
+    }
+    free(buffer);
+    return 0;
+}
@@ -0,0 +1,118 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// Lockstep batch scan against one stream at a time
+// Usage: bench/batch [MB] [repetitions]
+
+#include <time.h>
+#include "structures.h"
+#include "nfa.h"
+#include "dfa.h"
+#include "parse.h"
+#include "table.h"
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// best of the repetitions, in MB/s (batch = 0: one stream at a time)
+static double measure(compactTable *T, const char **strs, size_t *lens, int n, int batch, int repeat, int *results)
+{
+    double best = 1e30, t;
+    size_t size = 0;
+    int r, i;
+    for (i = 0; i < n; i++)
+        size += lens[i];
+    for (r = 0; r < repeat; r++)
+    {
+        t = now();
+        if (batch)
+            matchCompactTableBatch(T, strs, lens, n, results);
+        else
+            for (i = 0; i < n; i++)
+                results[i] = matchCompactTable(T, strs[i], lens[i]);
+        t = now() - t;
+        if (t < best)
+            best = t;
+    }
+    return size / best / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    // no state dies on random text, so every stream is read to the end
+    char *regexes[] = {"(a|b)*a(a|b)(a|b)(a|b)(a|b)", "(0|1|2|3|4|5|6|7|8|9)*(42|7(0|1)*7)(0|1|2|3|4|5|6|7|8|9)",
+                       "((a|b|c)(a|b|c)(a|b|c)(a|b|c)(a|b|c)(a|b|c)(a|b|c))*", NULL};
+    size_t lengths[] = {16, 100, 1000, 0};
+    size_t size = (argc > 1 ? atol(argv[1]) : 32) << 20;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    char *buffer = malloc(size);
+    int i, l;
+    printf("%-28s %6s %6s %12s %12s %12s %8s\n", "regex", "states", "length", "single", "single+accel", "batch",
+           "speedup");
+    for (i = 0; regexes[i]; i++)
+    {
+        nfa *N = parseRegex(regexes[i]);
+        dfa *D = nfaToDfa(N), *Dmin = minimize(D);
+        compactTable *T = buildCompactTable(Dmin);
+        int nAccel = T->nAccel;
+        size_t j;
+        srand(i + 1);
+        for (j = 0; j < size; j++)
+            buffer[j] = Dmin->sigma[rand() % Dmin->nSymbols];
+        for (l = 0; lengths[l]; l++)
+        {
+            int n = size / lengths[l], *single = malloc(n * sizeof(int)), *batch = malloc(n * sizeof(int));
+            const char **strs = malloc(n * sizeof(char *));
+            size_t *lens = malloc(n * sizeof(size_t));
+            double plain, accel, lockstep;
+            int k;
+            for (k = 0; k < n; k++)
+            {
+                strs[k] = buffer + k * lengths[l];
+                lens[k] = lengths[l];
+            }
+            T->nAccel = 0;
+            plain = measure(T, strs, lens, n, 0, repeat, single);
+            T->nAccel = nAccel;
+            accel = measure(T, strs, lens, n, 0, repeat, single);
+            lockstep = measure(T, strs, lens, n, 1, repeat, batch);
+            for (k = 0; k < n && single[k] == batch[k]; k++)
+                ;
+            printf("%-28.28s %6d %6lu %7.0f MB/s %7.0f MB/s %7.0f MB/s %7.2fx%s\n", regexes[i], T->nStates,
+                   (unsigned long)lengths[l], plain, accel, lockstep, lockstep / (plain > accel ? plain : accel),
+                   k < n ? "  (results differ!)" : "");
+            free(single);
+            free(batch);
+            free(strs);
+            free(lens);
+        }
+        disposeCompactTable(T);
+        disposeNfaAutomata(N);
+        disposeDfaAutomata(D);
+        disposeDfaAutomata(Dmin);
+    }
+    free(buffer);
+    return 0;
+}
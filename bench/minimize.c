@@ -0,0 +1,146 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// Parallel partition refinement against minimize() (one thread)
+// Usage: bench/minimize [states (thousands)] [copies] [symbols]
+// The dfa is a random automaton copied several times (each transition
+// goes to a random copy), so it minimizes to about states / copies
+
+#include <time.h>
+#include "structures.h"
+#include "dfa.h"
+#include "refine.h"
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static dfa *copiedDfa(int nStates, int copies, int nSymbols, unsigned seed)
+{
+    dfa *D = malloc(sizeof(dfa));
+    int m = nStates / copies, i, j;
+    int *base = malloc((size_t)m * nSymbols * sizeof(int));
+    char *final = malloc(m);
+    dfaState **states = malloc(nStates * sizeof(dfaState *));
+    srand(seed);
+    for (i = 0; i < m; i++)
+    {
+        final[i] = rand() & 1;
+        for (j = 0; j < nSymbols; j++)
+            base[i * nSymbols + j] = rand() % m;
+    }
+    D->nStates = m * copies;
+    D->nSymbols = nSymbols;
+    D->sigma = malloc(nSymbols + 1);
+    for (j = 0; j < nSymbols; j++)
+        D->sigma[j] = 'a' + j;
+    D->sigma[nSymbols] = 0;
+    D->transitions = malloc((size_t)D->nStates * nSymbols * sizeof(int));
+    for (i = 0; i < D->nStates; i++)
+    {
+        states[i] = malloc(sizeof(dfaState));
+        states[i]->final = final[i % m];
+        states[i]->initial = !i;
+        states[i]->kind = STATE_LIVE;
+        states[i]->stateSet = NULL;
+        states[i]->next = NULL;
+        if (i)
+            states[i - 1]->next = states[i];
+        for (j = 0; j < nSymbols; j++)
+            D->transitions[(size_t)i * nSymbols + j] = rand() % copies * m + base[i % m * nSymbols + j];
+    }
+    D->states = states[0];
+    free(base);
+    free(final);
+    free(states);
+    return D;
+}
+
+static void disposeStates(dfa *D)
+{
+    while (D->states)
+    {
+        dfaState *st = D->states;
+        D->states = st->next;
+        free(st);
+    }
+    disposeDfaAutomata(D);
+}
+
+// same states (with the same sets), transitions and flags
+static int sameDfa(dfa *A, dfa *B)
+{
+    dfaState *a = A->states, *b = B->states;
+    if (A->nStates != B->nStates || memcmp(A->transitions, B->transitions, (size_t)A->nStates * A->nSymbols * sizeof(int)))
+        return 0;
+    for (; a && b; a = a->next, b = b->next)
+    {
+        set *x = a->stateSet, *y = b->stateSet;
+        if (a->final != b->final || a->initial != b->initial || a->kind != b->kind)
+            return 0;
+        for (; x && y && x->info == y->info; x = x->next, y = y->next)
+            ;
+        if (x || y)
+            return 0;
+    }
+    return !a && !b;
+}
+
+int main(int argc, char **argv)
+{
+    int threads[] = {1, 2, 4, 8, 16, 32, 64};
+    int nStates = (argc > 1 ? atoi(argv[1]) : 1000) * 1000;
+    int copies = argc > 2 ? atoi(argv[2]) : 10;
+    int nSymbols = argc > 3 ? atoi(argv[3]) : 4;
+    int nThreads = sizeof(threads) / sizeof(threads[0]), i, identical = 1;
+    dfa *D, *Dmin, *P;
+    double t, base = 0;
+    // identical output: one thread on a small dfa
+    D = copiedDfa(20000, 10, nSymbols, 7);
+    Dmin = minimize(D);
+    for (i = 0; i < nThreads; i++)
+    {
+        P = minimizeParallel(D, threads[i]);
+        identical &= sameDfa(Dmin, P);
+        disposeDfaAutomata(P);
+    }
+    printf("identical to minimize() on %d states (%d minimized): %s\n\n", D->nStates, Dmin->nStates,
+           identical ? "yes" : "NO");
+    disposeDfaAutomata(Dmin);
+    disposeStates(D);
+    D = copiedDfa(nStates, copies, nSymbols, 11);
+    printf("%8s %10s %10s %10s %8s\n", "threads", "states", "minimized", "time", "speedup");
+    for (i = 0; i < nThreads; i++)
+    {
+        t = now();
+        P = minimizeParallel(D, threads[i]);
+        t = now() - t;
+        if (!i)
+            base = t;
+        printf("%8d %10d %10d %8.3f s %7.2fx\n", threads[i], D->nStates, P->nStates, t, base / t);
+        disposeDfaAutomata(P);
+    }
+    disposeStates(D);
+    return !identical;
+}
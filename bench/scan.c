@@ -0,0 +1,279 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// redfa against POSIX regcomp/regexec over synthetic corpora
+// Usage: bench/scan [MB] [repetitions] [match density %]
+// Corpora are generated from fixed seeds (same bytes on every run):
+//   log    -> log lines of words, numbers and paths
+//   random -> lines of random [a-z0-9] words, a sample match of some
+//             pattern on density % of the lines
+//   binary -> random bytes 0-255 with the samples at the same density
+// Tasks:
+//   search -> non overlapping matches anywhere (redfaSearch, regexec)
+//   lines  -> lines matched as a whole (redfaMatch, regexec "^(p)$")
+// Output (one CSV row per engine, corpus, task and pattern):
+//   engine,corpus,task,pattern,bytes,seconds,mb_s,ns_byte,matches
+// The engines differ in which match they report (redfa: earliest end,
+// POSIX: leftmost longest), so search counts may differ
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <regex.h>
+#include "redfa.h"
+
+typedef struct pattern
+{
+    const char *regex;
+    const char *sample; // a string the regex matches
+} pattern;
+
+static pattern patterns[] = {
+    {"error", "error"},
+    {"get|put|post|delete", "post"},
+    {"user(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)*", "user42"},
+    {"(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)(0|1|2|3|4|5|6|7|8|9)", "404"},
+    {"(a|b)*abb", "ababb"},
+    {"(a|b|c|d|e|f)(a|b|c|d|e|f|0|1|2|3|4|5|6|7|8|9)*x(0|1)(0|1)", "fa9x01"},
+    {NULL, NULL}};
+
+typedef struct corpus
+{
+    const char *name;
+    char *data;
+    size_t size;
+} corpus;
+
+// deterministic generator (same corpus on every machine)
+static unsigned long long seed;
+
+static unsigned next(void)
+{
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 33;
+}
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static size_t put(char *p, size_t pos, size_t size, const char *s)
+{
+    size_t n = strlen(s);
+    if (pos + n > size)
+        n = size - pos;
+    memcpy(p + pos, s, n);
+    return pos + n;
+}
+
+static void logCorpus(corpus *C, size_t size)
+{
+    static const char *methods[] = {"get", "put", "post", "delete", "head"};
+    static const char *levels[] = {"info", "info", "info", "warn", "error"};
+    char line[256];
+    size_t pos = 0;
+    C->name = "log";
+    C->data = malloc(size);
+    C->size = size;
+    seed = 1;
+    while (pos < size)
+    {
+        snprintf(line, sizeof(line), "2024%02u%02u %s host%u %s /api/v%u/items/%u user%u %u %uus\n",
+                 next() % 12 + 1, next() % 28 + 1, levels[next() % 5], next() % 64, methods[next() % 5],
+                 next() % 3 + 1, next() % 100000, next() % 5000, (next() % 4 + 2) * 100 + next() % 5,
+                 next() % 90000);
+        pos = put(C->data, pos, size, line);
+    }
+}
+
+static void randomCorpus(corpus *C, size_t size, int density)
+{
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+    size_t pos = 0;
+    int k = 0;
+    C->name = "random";
+    C->data = malloc(size);
+    C->size = size;
+    seed = 2;
+    while (pos < size)
+    {
+        if ((int)(next() % 100) < density)
+            pos = put(C->data, pos, size, patterns[k++ % 6].sample);
+        else
+        {
+            int n = next() % 9 + 4;
+            while (n-- && pos < size)
+                C->data[pos++] = alphabet[next() % 36];
+        }
+        if (pos < size)
+            C->data[pos++] = '\n';
+    }
+}
+
+static void binaryCorpus(corpus *C, size_t size, int density)
+{
+    size_t pos = 0;
+    int k = 0;
+    C->name = "binary";
+    C->data = malloc(size);
+    C->size = size;
+    seed = 3;
+    while (pos < size)
+    {
+        // blocks of 64 bytes, density % of them start with a sample
+        size_t end = pos + 64 < size ? pos + 64 : size;
+        if ((int)(next() % 100) < density)
+            pos = put(C->data, pos, end, patterns[k++ % 6].sample);
+        while (pos < end)
+            C->data[pos++] = next() & 0xFF;
+    }
+}
+
+static long redfaSearchAll(redfa *R, corpus *C)
+{
+    size_t pos = 0, start, end;
+    long count = 0;
+    while (redfaSearch(R, C->data, C->size, pos, &start, &end) > 0)
+    {
+        count++;
+        pos = end;
+    }
+    return count;
+}
+
+static long redfaLines(redfa *R, corpus *C)
+{
+    const char *p = C->data, *end = C->data + C->size;
+    long count = 0;
+    while (p < end)
+    {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        count += redfaMatch(R, p, eol - p);
+        p = eol + 1;
+    }
+    return count;
+}
+
+// REG_STARTEND: bounds instead of a terminating NUL (binary input)
+static long posixSearchAll(regex_t *re, corpus *C)
+{
+    regmatch_t m;
+    size_t pos = 0;
+    long count = 0;
+    for (;;)
+    {
+        m.rm_so = pos;
+        m.rm_eo = C->size;
+        if (regexec(re, C->data, 1, &m, REG_STARTEND | (pos ? REG_NOTBOL : 0)))
+            break;
+        count++;
+        pos = m.rm_eo > m.rm_so ? (size_t)m.rm_eo : (size_t)m.rm_eo + 1;
+        if (pos >= C->size)
+            break;
+    }
+    return count;
+}
+
+static long posixLines(regex_t *re, corpus *C)
+{
+    const char *p = C->data, *end = C->data + C->size;
+    regmatch_t m;
+    long count = 0;
+    while (p < end)
+    {
+        const char *eol = memchr(p, '\n', end - p);
+        if (!eol)
+            eol = end;
+        // each line as its own string, so ^ anchors at its first byte
+        m.rm_so = 0;
+        m.rm_eo = eol - p;
+        count += !regexec(re, p, 1, &m, REG_STARTEND);
+        p = eol + 1;
+    }
+    return count;
+}
+
+static void report(const char *engine, corpus *C, const char *task, const char *regex, double seconds, long matches)
+{
+    printf("%s,%s,%s,%s,%lu,%.6f,%.1f,%.3f,%ld\n", engine, C->name, task, regex, (unsigned long)C->size, seconds,
+           C->size / seconds / 1e6, seconds * 1e9 / C->size, matches);
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = (argc > 1 ? atol(argv[1]) : 4) << 20;
+    int repeat = argc > 2 ? atoi(argv[2]) : 3;
+    int density = argc > 3 ? atoi(argv[3]) : 5;
+    corpus corpora[3];
+    int c, i, r, task;
+    logCorpus(corpora + 0, size);
+    randomCorpus(corpora + 1, size, density);
+    binaryCorpus(corpora + 2, size, density);
+    printf("engine,corpus,task,pattern,bytes,seconds,mb_s,ns_byte,matches\n");
+    for (i = 0; patterns[i].regex; i++)
+    {
+        char *anchored = malloc(strlen(patterns[i].regex) + 5);
+        regex_t search, lines;
+        int error;
+        redfa *R = redfaCompile(patterns[i].regex, REDFA_SEARCH, &error);
+        sprintf(anchored, "^(%s)$", patterns[i].regex);
+        if (!R || regcomp(&search, patterns[i].regex, REG_EXTENDED) ||
+            regcomp(&lines, anchored, REG_EXTENDED | REG_NOSUB))
+        {
+            fprintf(stderr, "cannot compile '%s'\n", patterns[i].regex);
+            return 1;
+        }
+        for (c = 0; c < 3; c++)
+            for (task = 0; task < 2; task++)
+            {
+                double best[2] = {1e30, 1e30};
+                long matches[2] = {0, 0};
+                for (r = 0; r < repeat; r++)
+                {
+                    double t = now();
+                    matches[0] = task ? redfaLines(R, corpora + c) : redfaSearchAll(R, corpora + c);
+                    if ((t = now() - t) < best[0])
+                        best[0] = t;
+                    t = now();
+                    matches[1] = task ? posixLines(&lines, corpora + c) : posixSearchAll(&search, corpora + c);
+                    if ((t = now() - t) < best[1])
+                        best[1] = t;
+                }
+                report("redfa", corpora + c, task ? "lines" : "search", patterns[i].regex, best[0], matches[0]);
+                report("posix", corpora + c, task ? "lines" : "search", patterns[i].regex, best[1], matches[1]);
+                fflush(stdout);
+            }
+        redfaFree(R);
+        regfree(&search);
+        regfree(&lines);
+        free(anchored);
+    }
+    for (c = 0; c < 3; c++)
+        free(corpora[c].data);
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// Request latency against a running server (redfa serve <socket>)
+// Usage: bench/serve <socket> [clients] [requests per client] [pipeline depth]
+// Each client keeps up to depth match requests in flight; the latency
+// of a request goes from its send to the arrival of its reply
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define INPUT 64
+
+typedef struct client
+{
+    const char *path;
+    int requests;
+    int depth;
+    double *latency;
+    long matches;
+    int failed;
+} client;
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int sendAll(int fd, const void *p, size_t n)
+{
+    while (n)
+    {
+        ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+        if (k <= 0)
+            return -1;
+        p = (const char *)p + k;
+        n -= k;
+    }
+    return 0;
+}
+
+static int recvAll(int fd, void *p, size_t n)
+{
+    while (n)
+    {
+        ssize_t k = recv(fd, p, n, 0);
+        if (k <= 0)
+            return -1;
+        p = (char *)p + k;
+        n -= k;
+    }
+    return 0;
+}
+
+// one frame: [length][op][payload]; the reply payload goes to reply
+static int request(int fd, char op, const void *payload, uint32_t n, char *reply, uint32_t *size)
+{
+    uint32_t len = n + 1;
+    if (sendAll(fd, &len, sizeof(len)) || sendAll(fd, &op, 1) || sendAll(fd, payload, n))
+        return -1;
+    if (recvAll(fd, &len, sizeof(len)) || len > *size || recvAll(fd, reply, len))
+        return -1;
+    *size = len;
+    return 0;
+}
+
+static int connectServer(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+        return -1;
+    return fd;
+}
+
+static void *runClient(void *arg)
+{
+    client *C = arg;
+    const char *regex = "(a|b)*a(a|b)(a|b)(a|b)";
+    char reply[256], frame[sizeof(uint32_t) + 1 + sizeof(uint32_t) + INPUT];
+    double *sent = malloc(C->depth * sizeof(double));
+    uint32_t id, size = sizeof(reply), len = sizeof(frame) - sizeof(uint32_t);
+    unsigned seed = (unsigned)(size_t)C;
+    int fd = connectServer(C->path), issued = 0, received = 0, i;
+    if (fd < 0 || request(fd, 'C', regex, strlen(regex), reply, &size) || reply[0] != 'C')
+    {
+        C->failed = 1;
+        free(sent);
+        return NULL;
+    }
+    memcpy(&id, reply + 1, sizeof(id));
+    memcpy(frame, &len, sizeof(len));
+    frame[sizeof(len)] = 'M';
+    memcpy(frame + sizeof(len) + 1, &id, sizeof(id));
+    while (received < C->requests)
+    {
+        // keep the pipeline full, then wait for the oldest reply
+        while (issued < C->requests && issued - received < C->depth)
+        {
+            char *input = frame + sizeof(len) + 1 + sizeof(id);
+            for (i = 0; i < INPUT; i++)
+                input[i] = "ab"[rand_r(&seed) & 1];
+            sent[issued % C->depth] = now();
+            if (sendAll(fd, frame, sizeof(frame)))
+                break;
+            issued++;
+        }
+        if (recvAll(fd, &len, sizeof(len)) || len != 2 || recvAll(fd, reply, len) || reply[0] != 'M')
+        {
+            C->failed = 1;
+            break;
+        }
+        C->latency[received] = (now() - sent[received % C->depth]) * 1e6;
+        C->matches += reply[1];
+        received++;
+        len = sizeof(frame) - sizeof(uint32_t);
+    }
+    close(fd);
+    free(sent);
+    return NULL;
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv)
+{
+    int nClients = argc > 2 ? atoi(argv[2]) : 4;
+    int requests = argc > 3 ? atoi(argv[3]) : 20000;
+    int depth = argc > 4 ? atoi(argv[4]) : 8, i;
+    client *clients;
+    pthread_t *threads;
+    double *all, start, elapsed;
+    long total = 0, matches = 0;
+    if (argc < 2 || nClients < 1 || requests < 1 || depth < 1)
+    {
+        printf("Usage: %s <socket> [clients] [requests per client] [pipeline depth]\n", argv[0]);
+        return 1;
+    }
+    clients = calloc(nClients, sizeof(client));
+    threads = malloc(nClients * sizeof(pthread_t));
+    all = malloc((size_t)nClients * requests * sizeof(double));
+    start = now();
+    for (i = 0; i < nClients; i++)
+    {
+        clients[i].path = argv[1];
+        clients[i].requests = requests;
+        clients[i].depth = depth;
+        clients[i].latency = all + (size_t)i * requests;
+        pthread_create(threads + i, NULL, runClient, clients + i);
+    }
+    for (i = 0; i < nClients; i++)
+        pthread_join(threads[i], NULL);
+    elapsed = now() - start;
+    for (i = 0; i < nClients; i++)
+    {
+        if (clients[i].failed)
+        {
+            printf("Client %d failed (is '%s' served?)\n", i, argv[1]);
+            return 1;
+        }
+        matches += clients[i].matches;
+    }
+    total = (long)nClients * requests;
+    qsort(all, total, sizeof(double), compareDoubles);
+    printf("clients=%d depth=%d requests=%ld matches=%ld\n", nClients, depth, total, matches);
+    printf("throughput_rps=%.0f\n", total / elapsed);
+    printf("p50_us=%.1f\np90_us=%.1f\np99_us=%.1f\nmax_us=%.1f\n",
+           all[total / 2], all[total * 9 / 10], all[total * 99 / 100], all[total - 1]);
+    free(all);
+    free(clients);
+    free(threads);
+    return 0;
+}
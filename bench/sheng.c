@@ -0,0 +1,111 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+// Sheng (pshufb) engine against the compact table scanner
+// Usage: bench/sheng [MB] [repetitions]
+
+#include <time.h>
+#include "structures.h"
+#include "nfa.h"
+#include "dfa.h"
+#include "parse.h"
+#include "table.h"
+#include "sheng.h"
+
+static double now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+typedef int (*matchFunction)(void *, const char *, size_t);
+
+static int matchCompact(void *T, const char *str, size_t n)
+{
+    return matchCompactTable(T, str, n);
+}
+
+static int matchSheng(void *T, const char *str, size_t n)
+{
+    return matchShengTable(T, str, n);
+}
+
+// best of the repetitions, in MB/s
+static double measure(matchFunction match, void *T, char *buffer, size_t size, int repeat, int *result)
+{
+    double best = 1e30;
+    int r;
+    for (r = 0; r < repeat; r++)
+    {
+        double t = now();
+        *result += match(T, buffer, size);
+        t = now() - t;
+        if (t < best)
+            best = t;
+    }
+    return size / best / 1e6;
+}
+
+int main(int argc, char **argv)
+{
+    // no state dies on random text, so the whole buffer is scanned
+    char *regexes[] = {"(a|b)*abb", "((a|b)(a|b)(a|b))*", "(0|1(01*0)*1)*", "((0|1)(0|1)(0|1)(0|1)(0|1))*",
+                       "(a|b)*a(a|b)(a|b)", "(a|b|c)*(abc|cab)", NULL};
+    size_t size = (argc > 1 ? atol(argv[1]) : 64) << 20;
+    int repeat = argc > 2 ? atoi(argv[2]) : 5;
+    char *buffer = malloc(size);
+    int i, result = 0;
+    if (!shengSupported())
+    {
+        printf("pshufb (SSSE3) not supported by this cpu\n");
+        return 1;
+    }
+    printf("%-28s %6s %12s %12s %12s %8s\n", "regex", "states", "table", "table+accel", "sheng", "speedup");
+    for (i = 0; regexes[i]; i++)
+    {
+        nfa *N = parseRegex(regexes[i]);
+        dfa *D = nfaToDfa(N), *Dmin = minimize(D);
+        compactTable *T = buildCompactTable(Dmin);
+        shengTable *K = buildShengTable(T);
+        double plain, accel, sheng;
+        int nAccel = T->nAccel;
+        size_t j;
+        // random text over the vocabulary of the regex
+        srand(i + 1);
+        for (j = 0; j < size; j++)
+            buffer[j] = Dmin->sigma[rand() % Dmin->nSymbols];
+        T->nAccel = 0;
+        plain = measure(matchCompact, T, buffer, size, repeat, &result);
+        T->nAccel = nAccel;
+        accel = measure(matchCompact, T, buffer, size, repeat, &result);
+        sheng = K ? measure(matchSheng, K, buffer, size, repeat, &result) : 0;
+        printf("%-28s %6d %9.0f MB/s %7.0f MB/s %7.0f MB/s %7.2fx\n", regexes[i], T->nStates, plain, accel, sheng,
+               sheng / (plain > accel ? plain : accel));
+        disposeShengTable(K);
+        disposeCompactTable(T);
+        disposeNfaAutomata(N);
+        disposeDfaAutomata(D);
+        disposeDfaAutomata(Dmin);
+    }
+    free(buffer);
+    return result < 0;
+}
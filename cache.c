@@ -0,0 +1,109 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include <sys/stat.h>
+// unistd.h declares link(), a name taken by the nfa link type
+#define link unistdLink
+#include <unistd.h>
+#undef link
+#include "cache.h"
+#include "dfa.h"
+
+//Compile Cache Functions
+//-----------------------
+//  <dir>/<hash>.dfa = "redfa <version>" / postfix regex / saveDfa
+//  hash = FNV-1a 64 of the version and the postfix regex
+
+// FNV-1a 64 bits
+static uint64_t hashString(uint64_t h, const char *s)
+{
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 1099511628211ULL;
+    return h;
+}
+
+uint64_t hashPostfix(char *postfix)
+{
+    char version[16];
+    sprintf(version, "%d:", CACHE_VERSION);
+    return hashString(hashString(14695981039346656037ULL, version), postfix);
+}
+
+static char *cachePath(char *dir, char *postfix, char *suffix)
+{
+    char *path = malloc(strlen(dir) + 40);
+    sprintf(path, "%s/%016llx.dfa%s", dir, (unsigned long long)hashPostfix(postfix), suffix);
+    return path;
+}
+
+dfa *loadCachedDfa(char *dir, char *postfix)
+{
+    char *path = cachePath(dir, postfix, "");
+    char *key = malloc(strlen(postfix) + 2);
+    FILE *file = fopen(path, "rt");
+    dfa *D = NULL;
+    int version;
+    free(path);
+    if (!file)
+    {
+        free(key);
+        return NULL;
+    }
+    // header must match (the hash may collide)
+    if (fscanf(file, "redfa %d\n", &version) == 1 && version == CACHE_VERSION &&
+        fgets(key, strlen(postfix) + 2, file) && !strncmp(key, postfix, strlen(postfix)) &&
+        key[strlen(postfix)] == '\n')
+        D = loadDfa(file);
+    fclose(file);
+    free(key);
+    return D;
+}
+
+// writes a temporary file and renames it: readers never see partial
+// files and concurrent writers of the same key just replace each other
+int saveCachedDfa(char *dir, char *postfix, dfa *D)
+{
+    char *path = cachePath(dir, postfix, "");
+    char *temp = malloc(strlen(path) + 8);
+    FILE *file = NULL;
+    int fd, ok = 0;
+    // mkstemp creates a name no other process or thread holds
+    sprintf(temp, "%s.XXXXXX", path);
+    fd = mkstemp(temp);
+    if (fd >= 0 && (fchmod(fd, 0644) || !(file = fdopen(fd, "w"))))
+    {
+        close(fd);
+        remove(temp);
+    }
+    if (file)
+    {
+        fprintf(file, "redfa %d\n%s\n", CACHE_VERSION, postfix);
+        saveDfa(file, D);
+        ok = !ferror(file);
+        ok = !fclose(file) && ok;
+        ok = ok && !rename(temp, path);
+        if (!ok)
+            remove(temp);
+    }
+    free(path);
+    free(temp);
+    return ok;
+}
@@ -0,0 +1,13 @@
+#ifndef __CACHE__
+#define __CACHE__
+#include "structures.h"
+
+#define CACHE_VERSION 1
+
+//Compile Cache Functions
+//-----------------------
+uint64_t hashPostfix(char *);
+dfa *loadCachedDfa(char *, char *);
+int saveCachedDfa(char *, char *, dfa *);
+
+#endif
@@ -0,0 +1,283 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "comb.h"
+#include "dfa.h"
+
+//Comb (Row Displacement) Table Functions
+//---------------------------------------
+
+typedef struct rowInfo
+{
+    int state;
+    int count;
+} rowInfo;
+
+static int compareRows(const void *a, const void *b)
+{
+    const rowInfo *x = a, *y = b;
+    if (x->count != y->count)
+        return y->count - x->count;
+    return x->state - y->state;
+}
+
+static unsigned hashRow(int *row, int n)
+{
+    unsigned h = 2166136261u;
+    int i;
+    for (i = 0; i < n; i++)
+        h = (h ^ row[i]) * 16777619u;
+    return h;
+}
+
+// Free lists of the placement: a free position x has link[x] == x, a
+// taken one links to a later position (path halving on lookup)
+//  slot -> next/check entries, base -> row offsets (one row per base)
+typedef struct combSpace
+{
+    int capacity;
+    int *slot;
+    int *base;
+} combSpace;
+
+// bases tried before the search jumps to the end of the table
+#define COMB_TRIES 64
+
+static int nextFree(int *link, int x)
+{
+    while (link[x] != x)
+    {
+        link[x] = link[link[x]];
+        x = link[x];
+    }
+    return x;
+}
+
+// grows next/check and the free lists so that position size-1 is valid
+// (the lists have one more entry, always free, as sentinel)
+static void growComb(combTable *T, combSpace *S, int size)
+{
+    int i, old = S->capacity;
+    if (size <= old)
+        return;
+    if (!S->capacity)
+        S->capacity = 64;
+    while (S->capacity < size)
+        S->capacity *= 2;
+    T->next = realloc(T->next, S->capacity * sizeof(int));
+    T->check = realloc(T->check, S->capacity * sizeof(int));
+    S->slot = realloc(S->slot, (S->capacity + 1) * sizeof(int));
+    S->base = realloc(S->base, (S->capacity + 1) * sizeof(int));
+    for (i = old; i < S->capacity; i++)
+    {
+        T->next[i] = 0;
+        T->check[i] = -1;
+    }
+    for (i = old; i <= S->capacity; i++)
+        S->slot[i] = S->base[i] = i;
+}
+
+// first fit: the first entry of the row tries each free slot, found in
+// near constant time; after COMB_TRIES conflicts only the end is tried
+static int placeRow(combTable *T, combSpace *S, int *cols, int m)
+{
+    int b, f, j, tries = 0;
+    if (!m)
+    {
+        b = nextFree(S->base, 0);
+        growComb(T, S, b + T->nClasses);
+        return b;
+    }
+    for (f = nextFree(S->slot, cols[0]);; f = nextFree(S->slot, f + 1))
+    {
+        b = f - cols[0];
+        growComb(T, S, b + T->nClasses);
+        if (S->base[b] == b)
+        {
+            for (j = 1; j < m && T->check[b + cols[j]] < 0; j++)
+                ;
+            if (j == m)
+                return b;
+        }
+        // jump to the last row, where at most nClasses bases are tried
+        if (++tries == COMB_TRIES && f < T->size - T->nClasses)
+            f = T->size - T->nClasses;
+    }
+}
+
+combTable *buildCombTable(dfa *D)
+{
+    combTable *T = malloc(sizeof(combTable));
+    int nStates, nClasses, nReps = 0, nHash;
+    int *rows, *rep, *hashTab, *cols, *counts, i, j, k;
+    combSpace space = {0, NULL, NULL};
+    rowInfo *order;
+    dfaState *st;
+    T->dead = deadState(D);
+    nStates = T->nStates = D->nStates + (T->dead < 0);
+    if (T->dead < 0)
+        T->dead = D->nStates;
+    nClasses = T->nClasses = D->nSymbols + 1;
+    T->initial = initialState(D);
+    memset(T->classes, 0, sizeof(T->classes));
+    for (j = 0; j < D->nSymbols; j++)
+        T->classes[(unsigned char)D->sigma[j]] = j + 1;
+    T->accept = calloc(nStates, sizeof(unsigned char));
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        T->accept[i] = st->final;
+    // Expanded rows (class 0 = bytes outside sigma)
+    rows = malloc((size_t)nStates * nClasses * sizeof(int));
+    for (i = 0; i < nStates; i++)
+    {
+        rows[(size_t)i * nClasses] = T->dead;
+        for (j = 0; j < D->nSymbols; j++)
+            rows[(size_t)i * nClasses + j + 1] = i < D->nStates ? D->transitions[i * D->nSymbols + j] : T->dead;
+    }
+    // Equivalent rows: rep[i] = first state with the same row
+    rep = malloc(nStates * sizeof(int));
+    for (nHash = 1; nHash < 2 * nStates; nHash *= 2)
+        ;
+    hashTab = malloc(nHash * sizeof(int));
+    for (k = 0; k < nHash; k++)
+        hashTab[k] = -1;
+    for (i = 0; i < nStates; i++)
+    {
+        int *row = rows + (size_t)i * nClasses;
+        k = hashRow(row, nClasses) & (nHash - 1);
+        while (hashTab[k] >= 0 && memcmp(rows + (size_t)hashTab[k] * nClasses, row, nClasses * sizeof(int)))
+            k = (k + 1) & (nHash - 1);
+        if (hashTab[k] < 0)
+            hashTab[k] = i;
+        rep[i] = hashTab[k];
+    }
+    free(hashTab);
+    // Default = most frequent target of each representative row (a
+    // single target instead of flex's default state chain, so a lookup
+    // is one check and never follows a chain of template rows); targets
+    // are counted in counts[], reset by the entries of the row
+    T->def = malloc(nStates * sizeof(int));
+    T->base = malloc(nStates * sizeof(int));
+    order = malloc(nStates * sizeof(rowInfo));
+    counts = calloc(nStates, sizeof(int));
+    for (i = 0; i < nStates; i++)
+    {
+        int *row = rows + (size_t)i * nClasses, best = 0, bestCount = 0;
+        if (rep[i] != i)
+            continue;
+        for (j = 0; j < nClasses; j++)
+            counts[row[j]]++;
+        for (j = 0; j < nClasses; j++)
+            if (counts[row[j]] > bestCount)
+            {
+                bestCount = counts[row[j]];
+                best = row[j];
+            }
+        for (j = 0; j < nClasses; j++)
+            counts[row[j]] = 0;
+        T->def[i] = best;
+        order[nReps].state = i;
+        order[nReps++].count = nClasses - bestCount;
+    }
+    // First fit decreasing: densest rows are placed first
+    qsort(order, nReps, sizeof(rowInfo), compareRows);
+    T->next = NULL;
+    T->check = NULL;
+    T->size = 0;
+    cols = malloc(nClasses * sizeof(int));
+    growComb(T, &space, nClasses);
+    for (k = 0; k < nReps; k++)
+    {
+        int s = order[k].state, *row = rows + (size_t)s * nClasses, b, m = 0;
+        for (j = 0; j < nClasses; j++)
+            if (row[j] != T->def[s])
+                cols[m++] = j;
+        b = placeRow(T, &space, cols, m);
+        space.base[b] = b + 1;
+        T->base[s] = b;
+        for (j = 0; j < m; j++)
+        {
+            T->next[b + cols[j]] = row[cols[j]];
+            T->check[b + cols[j]] = b;
+            space.slot[b + cols[j]] = b + cols[j] + 1;
+        }
+        if (b + nClasses > T->size)
+            T->size = b + nClasses;
+    }
+    for (i = 0; i < nStates; i++)
+    {
+        T->base[i] = T->base[rep[i]];
+        T->def[i] = T->def[rep[i]];
+    }
+    T->next = realloc(T->next, T->size * sizeof(int));
+    T->check = realloc(T->check, T->size * sizeof(int));
+    free(space.slot);
+    free(space.base);
+    free(cols);
+    free(order);
+    free(rep);
+    free(counts);
+    free(rows);
+    return T;
+}
+
+int matchCombTable(combTable *T, const char *str, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    const int *base = T->base, *def = T->def, *next = T->next, *check = T->check;
+    int s = T->initial, dead = T->dead;
+    // the dead state rejects every continuation: stop reading there
+    while (n-- && s != dead)
+    {
+        int b = base[s], i = b + T->classes[*p++];
+        s = check[i] == b ? next[i] : def[s];
+    }
+    return T->accept[s];
+}
+
+void displayCombTable(combTable *T)
+{
+    int i;
+    printf("\nComb table\n");
+    printf("----------\n");
+    printf("nStates  = %d (dead = %d)\n", T->nStates, T->dead);
+    printf("nClasses = %d\n", T->nClasses);
+    printf("size     = %lu bytes (int table = %lu bytes)\n",
+           (unsigned long)(2 * T->nStates + 2 * T->size) * sizeof(int),
+           (unsigned long)T->nStates * T->nClasses * sizeof(int));
+    printf("%6s %6s %6s\n", "state", "base", "def");
+    for (i = 0; i < T->nStates; i++)
+        printf("%5d%c %6d %6d\n", i, T->accept[i] ? '*' : ' ', T->base[i], T->def[i]);
+    printf("%6s %6s %6s\n", "index", "next", "check");
+    for (i = 0; i < T->size; i++)
+        if (T->check[i] >= 0)
+            printf("%6d %6d %6d\n", i, T->next[i], T->check[i]);
+}
+
+void disposeCombTable(combTable *T)
+{
+    if (!T) return;
+    free(T->accept);
+    free(T->base);
+    free(T->def);
+    free(T->next);
+    free(T->check);
+    free(T);
+}
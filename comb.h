@@ -0,0 +1,12 @@
+#ifndef __COMB__
+#define __COMB__
+#include "structures.h"
+
+//Comb (Row Displacement) Table Functions
+//---------------------------------------
+combTable *buildCombTable(dfa *);
+int matchCombTable(combTable *, const char *, size_t);
+void displayCombTable(combTable *);
+void disposeCombTable(combTable *);
+
+#endif
@@ -19,7 +19,9 @@
  * along with redfa.  If not, see <https://www.gnu.org/licenses/>
  *-----------------------------------------------------------------------*/
 
+#include <limits.h>
 #include "dfa.h"
+#include "refine.h"
 #include "stack.h"
 #include "set.h"
 
@@ -40,6 +42,7 @@ int insertState(dfaState **D, set *S, int final, int initial)
     st = malloc(sizeof(dfaState));
     st->final = final;
     st->initial = initial;
+    st->kind = STATE_LIVE;
     st->stateSet = S;
     st->next = NULL;
     if (prev)
@@ -161,7 +164,12 @@ dfa *nfaToDfa(nfa *N)
     stack Stack = NULL;
     dfaState *stateList = NULL;
     int final, in, out;
-    sigma = sigma->next; // to skip EPSILON symbol
+    if (sigma && sigma->info == EPSILON)
+    {
+        set *tmp = sigma;
+        sigma = sigma->next; // to skip EPSILON symbol
+        free(tmp);
+    }
     final = inSet(N->nStates - 1, state);
     insertState(&stateList, state, final, 1); // to insert initial state
     nStates++;  // to count initial state
@@ -251,87 +259,48 @@ void disposeDfaAutomata(dfa *D)
 
 dfa *minimize(dfa *D)
 {
-    dfa *Dmin = malloc(sizeof(dfa));
-    int nStates = D->nStates;
-    int nSymbols = D->nSymbols;
-    dfaState *L, *st = D->states;
-    set *state;
-    int *transitions = malloc(nStates * sizeof(int));
-    int *groups = malloc(nStates * sizeof(int));
-    int *diff = malloc(nStates * sizeof(int));
-    int i, j, k, changed, countGroups, nGroups, nDiff, allFinal;
-    i = 0;
-    allFinal = 1;
+    int *partition = malloc(D->nStates * sizeof(int));
+    dfaState *st = D->states;
+    dfa *Dmin;
+    int i = 0;
     while (st)
     {
-        if (!st->final)
-           allFinal = 0;
-        groups[i++] = st->final;
+        partition[i++] = st->final; //nonfinal == 0, final == 1
         st = st->next;
     }
-    if (allFinal) {  // All states are final
-        Dmin->nStates = 1;
-        Dmin->nSymbols = nSymbols;
-        Dmin->sigma = malloc(nSymbols * sizeof(char) + 1);
-        for (i = 0; i < nSymbols; i++)
-            Dmin->sigma[i] = D->sigma[i];
-        Dmin->sigma[i] = 0;
-        Dmin->transitions = malloc(Dmin->nSymbols * sizeof(int));
-        state = NULL;
-        for (i = 0; i < D->nStates; i++)
-            insertSet (&state, i);
-        st = NULL;        
-        insertState (&st, state, 1, 1);
-        Dmin->states = st;
-        for (i = 0; i < nSymbols; i++)
-            Dmin->transitions[i] = 0; 
-        free(transitions);
-        free(groups);
-        free(diff);
-        return Dmin;       
-    }
-    changed = 1;
-    nGroups = 2; //nonfinal == 0, final == 1
-    while (changed && nGroups < nStates)
+    Dmin = minimizePartition(D, partition);
+    free(partition);
+    return Dmin;
+}
+
+// partition[i] = initial group of state i (groups numbered 0..n-1),
+// refined on this thread (see refine.c)
+dfa *minimizePartition(dfa *D, int *partition)
+{
+    return minimizePartitionParallel(D, partition, 1);
+}
+
+// dfa of the groups of states of D (groups numbered 0..nGroups-1): group
+// i = set of its states, transitions taken from its first state
+dfa *groupDfa(dfa *D, int *groups, int nGroups)
+{
+    dfa *Dmin = malloc(sizeof(dfa));
+    int nStates = D->nStates, nSymbols = D->nSymbols;
+    int *first = malloc(nGroups * sizeof(int));
+    char *final = calloc(nGroups, sizeof(char));
+    set **sets = calloc(nGroups, sizeof(set *));
+    dfaState *st, *tail = NULL;
+    int i, j;
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        final[groups[i]] |= st->final;
+    // backwards, so the sets come out sorted and first[] is the lowest
+    for (i = nStates - 1; i >= 0; i--)
     {
-        changed = 0;
-        //Group separation
-        for (i = 0; i < nStates; i++)
-        {
-            transitions[i] = 0;
-            for (j = 0; j < nSymbols; j++)
-            {
-                int group = groups[D->transitions[i * nSymbols + j]];
-                transitions[i] = 10 * transitions[i] + group;
-            }
-        }
-        //Group division
-        countGroups = nGroups;
-        for (k = 0; k < nGroups; k++)
-        {
-            nDiff = 0;
-            for (i = 0; i < nStates; i++)
-            {
-                if (groups[i] == k)
-                {
-                    int ehDiff = 1;
-                    for (j = 0; j < nDiff; j++)
-                        if (diff[j] == transitions[i])
-                            ehDiff = 0;
-                    if (ehDiff)
-                        diff[nDiff++] = transitions[i];
-                }
-            }
-            if (nDiff > 1)
-            {
-                changed = 1;
-                for (j = 1; j < nDiff; j++, countGroups++)
-                    for (i = 0; i < nStates; i++)
-                        if (groups[i] == k && diff[j] == transitions[i])
-                            groups[i] = countGroups;
-            }
-        }
-        nGroups = countGroups;
+        set *el = malloc(sizeof(set));
+        el->info = i;
+        el->next = sets[groups[i]];
+        sets[groups[i]] = el;
+        first[groups[i]] = i;
     }
     Dmin->nStates = nGroups;
     Dmin->nSymbols = nSymbols;
@@ -339,42 +308,290 @@ dfa *minimize(dfa *D)
     for (i = 0; i < nSymbols; i++)
         Dmin->sigma[i] = D->sigma[i];
     Dmin->sigma[i] = 0;
-    Dmin->transitions = malloc(Dmin->nStates * Dmin->nSymbols * sizeof(int));
-    st = NULL;
+    Dmin->transitions = malloc((size_t)nGroups * nSymbols * sizeof(int));
+    Dmin->states = NULL;
     for (i = 0; i < nGroups; i++)
     {
-        int final = 0;
-        int initial = 0;
-        L = D->states;
-        j = 0;
-        state = NULL;
-        while (L)
+        st = malloc(sizeof(dfaState));
+        st->final = final[i];
+        st->initial = i == groups[0];
+        st->kind = STATE_LIVE;
+        st->stateSet = sets[i];
+        st->next = NULL;
+        if (tail)
+            tail->next = st;
+        else
+            Dmin->states = st;
+        tail = st;
+        for (j = 0; j < nSymbols; j++)
+            Dmin->transitions[(size_t)i * nSymbols + j] = groups[D->transitions[(size_t)first[i] * nSymbols + j]];
+    }
+    classifyDfa(Dmin);
+    free(first);
+    free(final);
+    free(sets);
+    return Dmin;
+}
+
+int initialState(dfa *D)
+{
+    dfaState *st = D->states;
+    int i = 0;
+    while (st && !st->initial)
+    {
+        st = st->next;
+        i++;
+    }
+    return st ? i : 0;
+}
+
+// marks the states from which goal states (final or not final) can be
+// reached, walking the transitions backwards from them
+static void reachBackwards(dfa *D, int *first, int *from, int goalFinal, char *reach)
+{
+    int *queue = malloc(D->nStates * sizeof(int));
+    dfaState *st;
+    int i, k, head = 0, tail = 0;
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        if (!st->final == !goalFinal)
         {
-            if (groups[j] == i)
+            reach[i] = 1;
+            queue[tail++] = i;
+        }
+    while (head < tail)
+    {
+        int t = queue[head++];
+        for (k = first[t]; k < first[t + 1]; k++)
+            if (!reach[from[k]])
             {
-                insertSet(&state, j);
-                if (L->final)
-                    final = 1;
-                if (!j)
-                    initial = 1;
+                reach[from[k]] = 1;
+                queue[tail++] = from[k];
             }
-            L = L->next;
-            j++;
+    }
+    free(queue);
+}
+
+// Sets the kind of every state: dead states reach no final state and
+// accept sinks reach no non final state
+void classifyDfa(dfa *D)
+{
+    int n = D->nStates, m = D->nSymbols, i, j;
+    int *first = calloc(n + 1, sizeof(int)), *from = malloc(((size_t)n * m + 1) * sizeof(int));
+    char *accepts = calloc(n, 1), *rejects = calloc(n, 1);
+    dfaState *st;
+    // reverse transitions: from[first[t]..first[t+1]-1] = states into t
+    for (i = 0; i < n * m; i++)
+        first[D->transitions[i] + 1]++;
+    for (i = 0; i < n; i++)
+        first[i + 1] += first[i];
+    for (i = 0; i < n; i++)
+        for (j = 0; j < m; j++)
+        {
+            int t = D->transitions[i * m + j];
+            from[first[t]++] = i;
         }
-        insertState(&st, state, final, initial);
+    for (i = n; i > 0; i--)
+        first[i] = first[i - 1];
+    first[0] = 0;
+    reachBackwards(D, first, from, 1, accepts);
+    reachBackwards(D, first, from, 0, rejects);
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        st->kind = !accepts[i] ? STATE_DEAD : !rejects[i] ? STATE_SINK : STATE_LIVE;
+    free(first);
+    free(from);
+    free(accepts);
+    free(rejects);
+}
+
+// dead = non final state with every transition to itself
+int deadState(dfa *D)
+{
+    dfaState *st = D->states;
+    int i, j;
+    for (i = 0; st; i++, st = st->next)
+    {
+        if (st->final)
+            continue;
+        for (j = 0; j < D->nSymbols && D->transitions[i * D->nSymbols + j] == i; j++)
+            ;
+        if (j == D->nSymbols)
+            return i;
     }
-    Dmin->states = st;
-    for (i = 0; i < nGroups; i++)
-        for (j = 0; j < nSymbols; j++)
+    return -1;
+}
+
+typedef struct stateRank
+{
+    int state;
+    int bfs;
+    long visits;
+} stateRank;
+
+static int compareRanks(const void *a, const void *b)
+{
+    const stateRank *x = a, *y = b;
+    if (x->visits != y->visits)
+        return x->visits < y->visits ? 1 : -1;
+    return x->bfs - y->bfs;
+}
+
+// Same automaton with the states in breadth first order from the initial
+// state (unreachable states last) or, when visits is given, by decreasing
+// visits (ties in breadth first order): hot rows get adjacent ids
+dfa *renumberDfa(dfa *D, long *visits)
+{
+    dfa *R = malloc(sizeof(dfa));
+    int n = D->nStates, m = D->nSymbols;
+    int *order = malloc(n * sizeof(int)), *rank = malloc(n * sizeof(int));
+    dfaState **old = malloc(n * sizeof(dfaState *)), *st, *last = NULL;
+    int i, j, head = 0, count = 0;
+    for (i = 0, st = D->states; st; st = st->next)
+        old[i++] = st;
+    for (i = 0; i < n; i++)
+        rank[i] = -1;
+    order[count++] = initialState(D);
+    rank[order[0]] = 0;
+    while (head < count)
+    {
+        int s = order[head++];
+        for (j = 0; j < m; j++)
         {
-            for (k = 0; k < nStates && groups[k] != i; k++)
-                ;
-            Dmin->transitions[i * nSymbols + j] = groups[D->transitions[k * nSymbols + j]];
+            int t = D->transitions[s * m + j];
+            if (rank[t] < 0)
+            {
+                rank[t] = count;
+                order[count++] = t;
+            }
         }
-    free(transitions);
-    free(groups);
-    free(diff);
-    return Dmin;
+    }
+    for (i = 0; i < n; i++)
+        if (rank[i] < 0)
+        {
+            rank[i] = count;
+            order[count++] = i;
+        }
+    if (visits)
+    {
+        stateRank *ranks = malloc(n * sizeof(stateRank));
+        for (i = 0; i < n; i++)
+        {
+            ranks[i].state = order[i];
+            ranks[i].bfs = i;
+            ranks[i].visits = visits[order[i]];
+        }
+        qsort(ranks, n, sizeof(stateRank), compareRanks);
+        for (i = 0; i < n; i++)
+            order[i] = ranks[i].state;
+        free(ranks);
+    }
+    for (i = 0; i < n; i++)
+        rank[order[i]] = i;
+    R->nSymbols = m;
+    R->sigma = malloc(m * sizeof(char) + 1);
+    memcpy(R->sigma, D->sigma, m);
+    R->sigma[m] = 0;
+    R->nStates = n;
+    R->states = NULL;
+    R->transitions = malloc(n * m * sizeof(int));
+    for (i = 0; i < n; i++)
+    {
+        dfaState *ns = malloc(sizeof(dfaState));
+        ns->final = old[order[i]]->final;
+        ns->initial = old[order[i]]->initial;
+        ns->kind = old[order[i]]->kind;
+        ns->stateSet = NULL;
+        unionSet(&ns->stateSet, old[order[i]]->stateSet);
+        ns->next = NULL;
+        if (last)
+            last->next = ns;
+        else
+            R->states = ns;
+        last = ns;
+        for (j = 0; j < m; j++)
+            R->transitions[i * m + j] = rank[D->transitions[order[i] * m + j]];
+    }
+    free(order);
+    free(rank);
+    free(old);
+    return R;
+}
+
+// Text format: nSymbols sigma / nStates / per state "final initial
+// n e1..en" (set of corresponding states) / transitions row by row
+void saveDfa(FILE *file, dfa *D)
+{
+    dfaState *st;
+    int i, j;
+    fprintf(file, "%d %s\n%d\n", D->nSymbols, D->sigma, D->nStates);
+    for (st = D->states; st; st = st->next)
+    {
+        set *S = st->stateSet;
+        fprintf(file, "%d %d %d", st->final, st->initial, lengthSet(S));
+        for (; S; S = S->next)
+            fprintf(file, " %d", S->info);
+        fprintf(file, "\n");
+    }
+    for (i = 0; i < D->nStates; i++)
+    {
+        for (j = 0; j < D->nSymbols; j++)
+            fprintf(file, "%d ", D->transitions[i * D->nSymbols + j]);
+        fprintf(file, "\n");
+    }
+}
+
+dfa *loadDfa(FILE *file)
+{
+    dfa *D = malloc(sizeof(dfa));
+    dfaState *last = NULL;
+    int i, j, n, e, nInitial = 0;
+    D->nStates = 0;
+    D->states = NULL;
+    D->sigma = NULL;
+    D->transitions = NULL;
+    if (fscanf(file, "%d", &D->nSymbols) != 1 || D->nSymbols < 0 || D->nSymbols > 256)
+        goto error;
+    D->sigma = calloc(257, sizeof(char));
+    if (D->nSymbols && fscanf(file, " %256s", D->sigma) != 1)
+        goto error;
+    if ((int)strlen(D->sigma) != D->nSymbols)
+        goto error;
+    if (fscanf(file, "%d", &D->nStates) != 1 || D->nStates < 1 ||
+        (D->nSymbols && D->nStates > INT_MAX / D->nSymbols))
+        goto error;
+    for (i = 0; i < D->nStates; i++)
+    {
+        dfaState *st = malloc(sizeof(dfaState));
+        st->kind = STATE_LIVE;
+        st->stateSet = NULL;
+        st->next = NULL;
+        if (last)
+            last->next = st;
+        else
+            D->states = st;
+        last = st;
+        if (fscanf(file, "%d %d %d", &st->final, &st->initial, &n) != 3 ||
+            (unsigned)st->final > 1 || (unsigned)st->initial > 1 || n < 0)
+            goto error;
+        nInitial += st->initial;
+        for (j = 0; j < n; j++)
+        {
+            if (fscanf(file, "%d", &e) != 1)
+                goto error;
+            insertSet(&st->stateSet, e);
+        }
+    }
+    // exactly one initial state, every target below nStates
+    if (nInitial != 1)
+        goto error;
+    D->transitions = malloc((size_t)D->nStates * D->nSymbols * sizeof(int));
+    for (i = 0; i < D->nStates * D->nSymbols; i++)
+        if (fscanf(file, "%d", D->transitions + i) != 1 || D->transitions[i] < 0 || D->transitions[i] >= D->nStates)
+            goto error;
+    classifyDfa(D);
+    return D;
+error:
+    disposeDfaAutomata(D);
+    return NULL;
 }
 
 void showDfaStates(dfaState *D)
@@ -396,6 +613,7 @@ void showDfaStates(dfaState *D)
 
 void displayDfaAutomata(dfa *D, char *regex)
 {
+    dfaState *st;
     int i, j;
     printf("\nDFA : %s\n", regex);
     printf("------");
@@ -412,18 +630,20 @@ void displayDfaAutomata(dfa *D, char *regex)
     for (i = 0; i < D->nSymbols; i++)
         printf("%4c", D->sigma[i]);
     printf("\n");
-    for (i = 0; i < D->nStates; i++)
+    for (i = 0, st = D->states; i < D->nStates; i++, st = st->next)
     {
         printf("%4d:", i);
         for (j = 0; j < D->nSymbols; j++)
             printf("%4d", D->transitions[i * D->nSymbols + j]);
+        if (st->kind != STATE_LIVE)
+            printf("  %s", st->kind == STATE_DEAD ? "dead" : "accept sink");
         printf("\n");
     }
 }
 
 void saveDfaDotFile(dfa *A, char *name, char *regex, int showSetState)
 {
-    int i, j, initial;
+    int i, j;
     FILE *file = fopen(name, "wt");
     dfaState *st = A->states;
     fprintf(file, "digraph DFA {\n\trankdir=LR\n");
@@ -449,12 +669,10 @@ void saveDfaDotFile(dfa *A, char *name, char *regex, int showSetState)
            printSet (file, st->stateSet, 'i');
            fprintf(file, "</font></td> </tr>\n\t\t</TABLE>>]\n");
         }
-        if (st->initial)
-            initial = i;
         st = st->next;
         i++;
     }
-    fprintf(file, "\tinitial -> s%d\n", initial);
+    fprintf(file, "\tinitial -> s%d\n", initialState(A));
     for (i = 0; i < A->nStates; i++)
         for (j = 0; j < A->nSymbols; j++)
             fprintf(file, "\ts%d -> s%d [label = %c]\n", i, A->transitions[i * A->nSymbols + j], A->sigma[j]);
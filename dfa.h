@@ -14,6 +14,14 @@ dfa *nfaToDfa(nfa *);
 void displayDfaAutomata(dfa *, char *);
 void disposeDfaAutomata(dfa *);
 dfa *minimize(dfa *);
+dfa *minimizePartition(dfa *, int *);
+dfa *groupDfa(dfa *, int *, int);
+int initialState(dfa *);
+void classifyDfa(dfa *);
+int deadState(dfa *);
+dfa *renumberDfa(dfa *, long *);
 void saveDfaDotFile(dfa *, char *, char *, int);
+void saveDfa(FILE *, dfa *);
+dfa *loadDfa(FILE *);
 
 #endif
\ No newline at end of file
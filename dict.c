@@ -0,0 +1,304 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "dict.h"
+#include "dfa.h"
+#include "nfa.h"
+#include "set.h"
+
+//Dictionary Automata Functions
+//-----------------------------
+//  Minimal acyclic dfa of a word list, built incrementally from the
+//  sorted words (Daciuk, Mihov, Watson and Watson, 2000): after each
+//  word, the states off the common prefix with the next word are final
+//  and are merged with an equivalent registered state (or registered)
+
+// states under construction: next[s * nSymbols + c] (-1 = none)
+typedef struct dictTrie
+{
+    int nSymbols;
+    int nStates;
+    int capacity;
+    int *next;
+    char *final;
+    int *freeStates;
+    int nFree;
+    int *hash;
+    int nHash;
+    int nRegistered;
+} dictTrie;
+
+static int newDictState(dictTrie *T)
+{
+    int s, c;
+    if (T->nFree)
+        s = T->freeStates[--T->nFree];
+    else
+    {
+        if (T->nStates == T->capacity)
+        {
+            T->capacity = T->capacity ? 2 * T->capacity : 1024;
+            T->next = realloc(T->next, (size_t)T->capacity * T->nSymbols * sizeof(int));
+            T->final = realloc(T->final, T->capacity);
+            T->freeStates = realloc(T->freeStates, T->capacity * sizeof(int));
+        }
+        s = T->nStates++;
+    }
+    for (c = 0; c < T->nSymbols; c++)
+        T->next[(size_t)s * T->nSymbols + c] = -1;
+    T->final[s] = 0;
+    return s;
+}
+
+static unsigned hashDictState(dictTrie *T, int s)
+{
+    int *row = T->next + (size_t)s * T->nSymbols;
+    unsigned h = 2166136261u ^ T->final[s];
+    int c;
+    for (c = 0; c < T->nSymbols; c++)
+        h = (h ^ (unsigned)row[c]) * 16777619u;
+    return h;
+}
+
+static int equalDictStates(dictTrie *T, int a, int b)
+{
+    return T->final[a] == T->final[b] &&
+           !memcmp(T->next + (size_t)a * T->nSymbols, T->next + (size_t)b * T->nSymbols, T->nSymbols * sizeof(int));
+}
+
+static void growRegister(dictTrie *T)
+{
+    int *old = T->hash, nOld = T->nHash, i, k;
+    T->nHash = nOld ? 2 * nOld : 1024;
+    T->hash = malloc(T->nHash * sizeof(int));
+    for (k = 0; k < T->nHash; k++)
+        T->hash[k] = -1;
+    for (i = 0; i < nOld; i++)
+        if (old[i] >= 0)
+        {
+            k = hashDictState(T, old[i]) & (T->nHash - 1);
+            while (T->hash[k] >= 0)
+                k = (k + 1) & (T->nHash - 1);
+            T->hash[k] = old[i];
+        }
+    free(old);
+}
+
+// registered state equivalent to s, or s itself after registering it
+static int registerDictState(dictTrie *T, int s)
+{
+    int k;
+    if (2 * (T->nRegistered + 1) > T->nHash)
+        growRegister(T);
+    k = hashDictState(T, s) & (T->nHash - 1);
+    while (T->hash[k] >= 0)
+    {
+        if (equalDictStates(T, T->hash[k], s))
+            return T->hash[k];
+        k = (k + 1) & (T->nHash - 1);
+    }
+    T->hash[k] = s;
+    T->nRegistered++;
+    return s;
+}
+
+static int lastChild(dictTrie *T, int s)
+{
+    int c;
+    for (c = T->nSymbols - 1; c >= 0 && T->next[(size_t)s * T->nSymbols + c] < 0; c--)
+        ;
+    return c;
+}
+
+// replaces the last path from s by registered states
+static void replaceOrRegister(dictTrie *T, int s)
+{
+    int c = lastChild(T, s), child, q;
+    if (c < 0)
+        return;
+    child = T->next[(size_t)s * T->nSymbols + c];
+    replaceOrRegister(T, child);
+    q = registerDictState(T, child);
+    if (q != child)
+    {
+        T->next[(size_t)s * T->nSymbols + c] = q;
+        T->freeStates[T->nFree++] = child;
+    }
+}
+
+static int compareWords(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// dfa of the words (lowercased in place, empty words are skipped);
+// NULL if a word has a symbol outside the alphabet
+dfa *buildDictionary(char **words, int n)
+{
+    dictTrie T;
+    dfa *D;
+    dfaState *last = NULL;
+    char **sorted = malloc((n ? n : 1) * sizeof(char *)), *prev = "";
+    int index[256], *id, *queue, root, i, j, k, head = 0, tail = 0, dead = 0;
+    memset(index, -1, sizeof(index));
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; words[i][j]; j++)
+        {
+            words[i][j] = tolower(words[i][j]);
+            if (!isAlphabet(words[i][j]))
+            {
+                free(sorted);
+                return NULL;
+            }
+            index[(unsigned char)words[i][j]] = 0;
+        }
+        sorted[i] = words[i];
+    }
+    qsort(sorted, n, sizeof(char *), compareWords);
+    D = malloc(sizeof(dfa));
+    D->sigma = malloc(257);
+    for (i = 0, k = 0; i < 256; i++)
+        if (!index[i])
+        {
+            index[i] = k;
+            D->sigma[k++] = i;
+        }
+    D->sigma[k] = 0;
+    D->nSymbols = k;
+    memset(&T, 0, sizeof(T));
+    T.nSymbols = k;
+    root = newDictState(&T);
+    for (i = 0; i < n; i++)
+    {
+        char *w = sorted[i];
+        int s = root;
+        // common prefix with the previous word
+        for (j = 0; w[j] && w[j] == prev[j]; j++)
+            s = T.next[(size_t)s * T.nSymbols + index[(unsigned char)w[j]]];
+        if (!*w || (!w[j] && !prev[j]))
+            continue; // empty or repeated
+        replaceOrRegister(&T, s);
+        for (; w[j]; j++)
+        {
+            int t = newDictState(&T);
+            T.next[(size_t)s * T.nSymbols + index[(unsigned char)w[j]]] = t;
+            s = t;
+        }
+        T.final[s] = 1;
+        prev = w;
+    }
+    replaceOrRegister(&T, root);
+    // breadth first numbering of the live states, missing transitions go
+    // to a dead state appended at the end
+    id = malloc(T.nStates * sizeof(int));
+    queue = malloc(T.nStates * sizeof(int));
+    for (i = 0; i < T.nStates; i++)
+        id[i] = -1;
+    id[root] = 0;
+    queue[tail++] = root;
+    while (head < tail)
+    {
+        int s = queue[head++];
+        for (k = 0; k < T.nSymbols; k++)
+        {
+            int t = T.next[(size_t)s * T.nSymbols + k];
+            if (t < 0)
+                dead = 1;
+            else if (id[t] < 0)
+            {
+                id[t] = tail;
+                queue[tail++] = t;
+            }
+        }
+    }
+    D->nStates = tail + dead;
+    D->states = NULL;
+    D->transitions = malloc((size_t)D->nStates * (D->nSymbols ? D->nSymbols : 1) * sizeof(int));
+    for (i = 0; i < D->nStates; i++)
+    {
+        dfaState *st = malloc(sizeof(dfaState));
+        st->final = i < tail && T.final[queue[i]];
+        st->initial = i == 0;
+        st->kind = STATE_LIVE;
+        st->stateSet = NULL;
+        insertSet(&st->stateSet, i);
+        st->next = NULL;
+        if (last)
+            last->next = st;
+        else
+            D->states = st;
+        last = st;
+        for (k = 0; k < D->nSymbols; k++)
+        {
+            int t = i < tail ? T.next[(size_t)queue[i] * T.nSymbols + k] : -1;
+            D->transitions[i * D->nSymbols + k] = t < 0 ? tail : id[t];
+        }
+    }
+    classifyDfa(D);
+    free(id);
+    free(queue);
+    free(sorted);
+    free(T.next);
+    free(T.final);
+    free(T.freeStates);
+    free(T.hash);
+    return D;
+}
+
+// regex made only of words separated by '|' (no empty word)
+int literalAlternation(char *regex)
+{
+    int i, length = 0;
+    for (i = 0; regex[i]; i++)
+    {
+        if (regex[i] == '|')
+        {
+            if (!length)
+                return 0;
+            length = 0;
+        }
+        else if (isAlphabet(tolower(regex[i])))
+            length++;
+        else
+            return 0;
+    }
+    return length > 0;
+}
+
+// words of a literal alternation (pointers into a copy of the regex,
+// words[0] is the start of the copy)
+char **splitAlternation(char *regex, int *n)
+{
+    char *copy = strdup(regex), **words, *w;
+    int i;
+    for (i = 0, *n = 1; copy[i]; i++)
+        *n += copy[i] == '|';
+    words = malloc(*n * sizeof(char *));
+    for (i = 0, w = copy; i < *n; i++)
+    {
+        words[i] = w;
+        w = strchr(w, '|');
+        if (w)
+            *w++ = 0;
+    }
+    return words;
+}
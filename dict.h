@@ -0,0 +1,11 @@
+#ifndef __DICT__
+#define __DICT__
+#include "structures.h"
+
+//Dictionary Automata Functions
+//-----------------------------
+dfa *buildDictionary(char **, int);
+int literalAlternation(char *);
+char **splitAlternation(char *, int *);
+
+#endif
@@ -0,0 +1,216 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "equiv.h"
+#include "dfa.h"
+#include "pair.h"
+
+//DFA Comparison Functions
+//------------------------
+//  Both dfas run over the union of their vocabularies (pairOperand). A
+//  state of the pair (p, q) is p of A and q of B.
+
+// pair reached by symbol from pairs[parent]
+typedef struct pairNode
+{
+    int p;
+    int q;
+    int parent;
+    char symbol;
+} pairNode;
+
+static char *unionSigma(dfa *A, dfa *B)
+{
+    char *sigma = malloc(A->nSymbols + B->nSymbols + 1);
+    int c, n = 0;
+    for (c = 1; c < 256; c++)
+        if (memchr(A->sigma, c, A->nSymbols) || memchr(B->sigma, c, B->nSymbols))
+            sigma[n++] = c;
+    sigma[n] = 0;
+    return sigma;
+}
+
+int acceptDfa(dfa *D, const char *str)
+{
+    dfaState *st;
+    int s = initialState(D), i, j;
+    for (i = 0; str[i]; i++)
+    {
+        for (j = 0; j < D->nSymbols && D->sigma[j] != str[i]; j++)
+            ;
+        if (j == D->nSymbols)
+            return 0;
+        s = D->transitions[s * D->nSymbols + j];
+    }
+    for (st = D->states; s--; st = st->next)
+        ;
+    return st->final;
+}
+
+// differs = 1: final(p) != final(q), differs = 0: final(p) && !final(q)
+static int conflict(pairOperand *A, pairOperand *B, int p, int q, int differs)
+{
+    return differs ? A->final[p] != B->final[q] : A->final[p] && !B->final[q];
+}
+
+// Shortest string reaching a conflicting pair: breadth first over the
+// pairs reached from the initial one (only those are ever built).
+// Returns 1 if there is none
+static int searchPairs(pairOperand *A, pairOperand *B, char *sigma, int differs, char **witness)
+{
+    size_t capacity = 1024, tableSize = 2048, mask, n = 0, head = 0;
+    int *table = malloc(tableSize * sizeof(int)), nSigma = strlen(sigma), c, found = -1;
+    pairNode *pairs = malloc(capacity * sizeof(pairNode));
+    memset(table, -1, tableSize * sizeof(int));
+    mask = tableSize - 1;
+    pairs[n++] = (pairNode){A->initial, B->initial, -1, 0};
+    table[hashPair(A->initial, B->initial, mask)] = 0;
+    if (conflict(A, B, A->initial, B->initial, differs))
+        found = 0;
+    while (found < 0 && head < n)
+    {
+        pairNode x = pairs[head];
+        for (c = 0; c < nSigma && found < 0; c++)
+        {
+            int p = stepPairOperand(A, x.p, c), q = stepPairOperand(B, x.q, c);
+            size_t h = hashPair(p, q, mask);
+            while (table[h] >= 0 && (pairs[table[h]].p != p || pairs[table[h]].q != q))
+                h = (h + 1) & mask;
+            if (table[h] >= 0)
+                continue;
+            if (n == capacity)
+                pairs = realloc(pairs, (capacity *= 2) * sizeof(pairNode));
+            pairs[n] = (pairNode){p, q, (int)head, sigma[c]};
+            table[h] = n;
+            if (conflict(A, B, p, q, differs))
+                found = n;
+            n++;
+            if (2 * n > tableSize)
+            {
+                // rehash at twice the size
+                size_t i;
+                free(table);
+                tableSize *= 2;
+                mask = tableSize - 1;
+                table = malloc(tableSize * sizeof(int));
+                memset(table, -1, tableSize * sizeof(int));
+                for (i = 0; i < n; i++)
+                {
+                    h = hashPair(pairs[i].p, pairs[i].q, mask);
+                    while (table[h] >= 0)
+                        h = (h + 1) & mask;
+                    table[h] = i;
+                }
+            }
+        }
+        head++;
+    }
+    if (found >= 0 && witness)
+    {
+        int length = 0, i;
+        for (i = found; pairs[i].parent >= 0; i = pairs[i].parent)
+            length++;
+        *witness = malloc(length + 1);
+        (*witness)[length] = 0;
+        for (i = found; pairs[i].parent >= 0; i = pairs[i].parent)
+            (*witness)[--length] = pairs[i].symbol;
+    }
+    free(pairs);
+    free(table);
+    return found < 0;
+}
+
+static int findClass(int *parent, int x)
+{
+    while (parent[x] != x)
+        x = parent[x] = parent[parent[x]];
+    return x;
+}
+
+// Hopcroft-Karp: states of A (0..nA) and of B (nA+1..) in one
+// union-find; pairs are merged while exploring, so each merge happens
+// once and the work is near linear in the states times the symbols
+static int unionFindEquivalent(pairOperand *A, pairOperand *B, char *sigma)
+{
+    int nA = A->n + 1, total = nA + B->n + 1, nSigma = strlen(sigma);
+    int *parent = malloc(total * sizeof(int)), *stack = malloc(2 * total * sizeof(int));
+    int i, c, top = 0, equal = 1;
+    for (i = 0; i < total; i++)
+        parent[i] = i;
+    if (A->final[A->initial] != B->final[B->initial])
+        equal = 0;
+    parent[nA + B->initial] = A->initial;
+    stack[top++] = A->initial;
+    stack[top++] = B->initial;
+    while (top && equal)
+    {
+        int q = stack[--top], p = stack[--top];
+        for (c = 0; c < nSigma && equal; c++)
+        {
+            int p1 = stepPairOperand(A, p, c), q1 = stepPairOperand(B, q, c);
+            int x = findClass(parent, p1), y = findClass(parent, nA + q1);
+            if (x == y)
+                continue;
+            if (A->final[p1] != B->final[q1])
+                equal = 0;
+            parent[y] = x;
+            stack[top++] = p1;
+            stack[top++] = q1;
+        }
+    }
+    free(parent);
+    free(stack);
+    return equal;
+}
+
+// 1 if A and B accept the same strings; else *witness (if not NULL) is
+// a shortest string accepted by only one of them
+int equivalentDfa(dfa *A, dfa *B, char **witness)
+{
+    char *sigma = unionSigma(A, B);
+    pairOperand SA, SB;
+    int equal;
+    initPairOperand(&SA, A, sigma);
+    initPairOperand(&SB, B, sigma);
+    equal = unionFindEquivalent(&SA, &SB, sigma);
+    if (!equal)
+        searchPairs(&SA, &SB, sigma, 1, witness);
+    disposePairOperand(&SA);
+    disposePairOperand(&SB);
+    free(sigma);
+    return equal;
+}
+
+// 1 if every string accepted by A is accepted by B; else *witness is a
+// shortest string accepted by A and not by B
+int includedDfa(dfa *A, dfa *B, char **witness)
+{
+    char *sigma = unionSigma(A, B);
+    pairOperand SA, SB;
+    int included;
+    initPairOperand(&SA, A, sigma);
+    initPairOperand(&SB, B, sigma);
+    included = searchPairs(&SA, &SB, sigma, 0, witness);
+    disposePairOperand(&SA);
+    disposePairOperand(&SB);
+    free(sigma);
+    return included;
+}
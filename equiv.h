@@ -0,0 +1,11 @@
+#ifndef __EQUIV__
+#define __EQUIV__
+#include "structures.h"
+
+//DFA Comparison Functions
+//------------------------
+int acceptDfa(dfa *, const char *);
+int equivalentDfa(dfa *, dfa *, char **);
+int includedDfa(dfa *, dfa *, char **);
+
+#endif
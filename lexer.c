@@ -0,0 +1,221 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "lexer.h"
+#include "nfa.h"
+#include "dfa.h"
+#include "parse.h"
+#include "table.h"
+#include "refine.h"
+#include "ast.h"
+
+//Lexer Functions
+//---------------
+
+// first rule whose final nfa state is in S (finals is increasing)
+static int acceptedRule(set *S, int *finals, int nRules)
+{
+    while (S)
+    {
+        int lo = 0, hi = nRules - 1;
+        while (lo <= hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (finals[mid] == S->info)
+                return mid;
+            if (finals[mid] < S->info)
+                lo = mid + 1;
+            else
+                hi = mid - 1;
+        }
+        S = S->next;
+    }
+    return -1;
+}
+
+lexer *buildLexer(char **rules, int nRules, int nThreads)
+{
+    lexer *X = malloc(sizeof(lexer));
+    nfa **parts = malloc(nRules * sizeof(nfa *)), *N;
+    astNode **roots = malloc(nRules * sizeof(astNode *));
+    astTable *A = newAstTable();
+    int *finals = malloc(nRules * sizeof(int));
+    int *label = malloc((nRules + 1) * sizeof(int));
+    int *ruleD, *partition, i, r, offset, nLabels;
+    dfaState *st;
+    dfa *D;
+    for (r = 0; r < nRules; r++)
+    {
+        if (!(roots[r] = parseAst(A, rules[r])))
+        {
+            // invalid rule
+            disposeAstTable(A);
+            free(roots);
+            free(parts);
+            free(finals);
+            free(label);
+            free(X);
+            return NULL;
+        }
+    }
+    // all trees first: subtrees shared between rules build their nfa once
+    for (r = 0, offset = 1; r < nRules; r++)
+    {
+        parts[r] = astToReducedNfa(A, roots[r]);
+        offset += parts[r]->nStates;
+        finals[r] = offset - 1;
+    }
+    disposeAstTable(A);
+    free(roots);
+    N = buildAlternation(parts, nRules);
+    D = nfaToDfa(N);
+    // Accepted rule of each dfa state (priority = order of the rules)
+    ruleD = malloc(D->nStates * sizeof(int));
+    for (i = 0; i <= nRules; i++)
+        label[i] = -1;
+    for (i = 0, st = D->states; st; i++, st = st->next)
+    {
+        ruleD[i] = acceptedRule(st->stateSet, finals, nRules);
+        label[ruleD[i] + 1] = 0;
+    }
+    // Initial partition: one group per accepted rule, numbered densely
+    for (r = 0, nLabels = 0; r <= nRules; r++)
+        if (!label[r])
+            label[r] = nLabels++;
+    partition = malloc(D->nStates * sizeof(int));
+    for (i = 0; i < D->nStates; i++)
+        partition[i] = label[ruleD[i] + 1];
+    X->nRules = nRules;
+    X->maxLookahead = 0;
+    X->D = minimizePartitionParallel(D, partition, nThreads);
+    X->T = buildCompactTable(X->D);
+    X->rule = malloc(X->T->nStates * sizeof(int));
+    for (i = 0; i < X->T->nStates; i++)
+        X->rule[i] = -1;
+    for (i = 0, st = X->D->states; st; i++, st = st->next)
+        X->rule[i] = ruleD[st->stateSet->info];
+    for (r = 0; r < nRules; r++)
+        disposeNfaAutomata(parts[r]);
+    disposeNfaAutomata(N);
+    disposeDfaAutomata(D);
+    free(parts);
+    free(finals);
+    free(label);
+    free(ruleD);
+    free(partition);
+    return X;
+}
+
+// Longest accepted prefix of p: stops on the dead state (no longer
+// token is possible) or maxLookahead bytes after the last accept
+#define MUNCH_LOOP(name, type, op, row)                                         \
+    static size_t name(lexer *X, const unsigned char *p, size_t n, int *rule)   \
+    {                                                                           \
+        const type *t = X->T->data;                                             \
+        const unsigned char *c = X->T->classes;                                 \
+        const int *accept = X->rule;                                            \
+        uint32_t s = X->T->initial, dead = X->T->dead, k = X->T->row;           \
+        size_t i, last = 0, limit = X->maxLookahead;                            \
+        *rule = -1;                                                             \
+        for (i = 0; i < n; i++)                                                 \
+        {                                                                       \
+            s = t[(s op k) + c[p[i]]];                                          \
+            if (accept[s] >= 0)                                                 \
+            {                                                                   \
+                *rule = accept[s];                                              \
+                last = i + 1;                                                   \
+            }                                                                   \
+            else if (s == dead || (limit && i + 1 - last >= limit))             \
+                break;                                                          \
+        }                                                                       \
+        return last;                                                            \
+    }
+
+MUNCH_LOOP(munch8, uint8_t, <<, shift)
+MUNCH_LOOP(munch16, uint16_t, <<, shift)
+MUNCH_LOOP(munch32, uint32_t, <<, shift)
+MUNCH_LOOP(munchExact16, uint16_t, *, stride)
+MUNCH_LOOP(munchExact32, uint32_t, *, stride)
+
+int nextToken(lexer *X, const char *buffer, size_t size, size_t pos, token *tk)
+{
+    const unsigned char *p = (const unsigned char *)buffer + pos;
+    size_t n = size - pos;
+    if (pos >= size)
+        return 0;
+    if (X->T->shift < 0)
+        tk->length = X->T->width == 2 ? munchExact16(X, p, n, &tk->rule) : munchExact32(X, p, n, &tk->rule);
+    else
+        switch (X->T->width)
+        {
+        case 1:
+            tk->length = munch8(X, p, n, &tk->rule);
+            break;
+        case 2:
+            tk->length = munch16(X, p, n, &tk->rule);
+            break;
+        default:
+            tk->length = munch32(X, p, n, &tk->rule);
+        }
+    if (!tk->length) // no rule matches: one byte error token
+    {
+        tk->rule = -1;
+        tk->length = 1;
+    }
+    tk->offset = pos;
+    return 1;
+}
+
+long lexBuffer(lexer *X, const char *buffer, size_t size, void (*emit)(token *, void *), void *user)
+{
+    token tk;
+    size_t pos = 0;
+    long count = 0;
+    while (nextToken(X, buffer, size, pos, &tk))
+    {
+        emit(&tk, user);
+        pos += tk.length;
+        count++;
+    }
+    return count;
+}
+
+void displayLexer(lexer *X, char **rules)
+{
+    int i;
+    printf("\nLexer : %d rules\n", X->nRules);
+    printf("---------------\n");
+    for (i = 0; i < X->nRules; i++)
+        printf("%4d: %s\n", i, rules[i]);
+    displayDfaAutomata(X->D, "lexer");
+    printf("Rules    = [");
+    for (i = 0; i < X->D->nStates; i++)
+        printf("%d%s", X->rule[i], i < X->D->nStates - 1 ? "," : "]\n");
+}
+
+void disposeLexer(lexer *X)
+{
+    if (!X) return;
+    disposeDfaAutomata(X->D);
+    disposeCompactTable(X->T);
+    free(X->rule);
+    free(X);
+}
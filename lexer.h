@@ -0,0 +1,13 @@
+#ifndef __LEXER__
+#define __LEXER__
+#include "structures.h"
+
+//Lexer Functions
+//---------------
+lexer *buildLexer(char **, int, int);
+int nextToken(lexer *, const char *, size_t, size_t, token *);
+long lexBuffer(lexer *, const char *, size_t, void (*)(token *, void *), void *);
+void displayLexer(lexer *, char **);
+void disposeLexer(lexer *);
+
+#endif
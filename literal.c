@@ -0,0 +1,400 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "literal.h"
+#include "simd.h"
+#include "stack.h"
+#include "nfa.h"
+
+//Required Literal Functions
+//--------------------------
+
+#define MAX_LITERALS 32
+
+// Literal information of a subexpression
+//  exact  -> the only string matched (NULL if more than one)
+//  prefix -> every match starts with it
+//  suffix -> every match ends with it
+//  req    -> every match contains one of them (nReq = 0: nothing known)
+typedef struct factor
+{
+    char *exact;
+    char *prefix;
+    char *suffix;
+    int nReq;
+    char **req;
+} factor;
+
+static char *concatString(char *a, char *b)
+{
+    char *s = malloc(strlen(a) + strlen(b) + 1);
+    strcpy(s, a);
+    strcat(s, b);
+    return s;
+}
+
+static int minLength(char **req, int n)
+{
+    int i, m = n ? (int)strlen(req[0]) : 0;
+    for (i = 1; i < n; i++)
+        if ((int)strlen(req[i]) < m)
+            m = strlen(req[i]);
+    return m;
+}
+
+// longer shortest literal first, then fewer literals
+static int betterRequired(char **a, int na, char **b, int nb)
+{
+    int la = minLength(a, na), lb = minLength(b, nb);
+    if (la != lb)
+        return la > lb;
+    return na && na < nb;
+}
+
+static void disposeLiterals(char **req, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        free(req[i]);
+    free(req);
+}
+
+static void setRequired(factor *F, char **req, int n)
+{
+    disposeLiterals(F->req, F->nReq);
+    F->req = req;
+    F->nReq = n;
+}
+
+static char **singleLiteral(char *s)
+{
+    char **req = malloc(sizeof(char *));
+    req[0] = strdup(s);
+    return req;
+}
+
+static factor *symbolFactor(char c)
+{
+    factor *F = malloc(sizeof(factor));
+    char s[2] = {c, 0};
+    F->exact = strdup(s);
+    F->prefix = strdup(s);
+    F->suffix = strdup(s);
+    F->req = singleLiteral(s);
+    F->nReq = 1;
+    return F;
+}
+
+static void disposeFactor(factor *F)
+{
+    free(F->exact);
+    free(F->prefix);
+    free(F->suffix);
+    disposeLiterals(F->req, F->nReq);
+    free(F);
+}
+
+// A* may match the empty string: nothing of A is required
+static factor *kleeneFactor(void)
+{
+    factor *F = malloc(sizeof(factor));
+    F->exact = NULL;
+    F->prefix = strdup("");
+    F->suffix = strdup("");
+    F->req = NULL;
+    F->nReq = 0;
+    return F;
+}
+
+static factor *concatFactor(factor *A, factor *B)
+{
+    factor *F = malloc(sizeof(factor));
+    char *middle = concatString(A->suffix, B->prefix);
+    F->exact = A->exact && B->exact ? concatString(A->exact, B->exact) : NULL;
+    F->prefix = A->exact ? concatString(A->exact, B->prefix) : strdup(A->prefix);
+    F->suffix = B->exact ? concatString(A->suffix, B->exact) : strdup(B->suffix);
+    F->req = NULL;
+    F->nReq = 0;
+    if (F->exact)
+        setRequired(F, singleLiteral(F->exact), 1);
+    else
+    {
+        // best of A's, B's and the factor across the junction
+        char **best = A->req;
+        int i, nBest = A->nReq;
+        if (betterRequired(B->req, B->nReq, best, nBest))
+        {
+            best = B->req;
+            nBest = B->nReq;
+        }
+        if (*middle && betterRequired(&middle, 1, best, nBest))
+        {
+            best = &middle;
+            nBest = 1;
+        }
+        F->req = malloc((nBest ? nBest : 1) * sizeof(char *));
+        F->nReq = nBest;
+        for (i = 0; i < nBest; i++)
+            F->req[i] = strdup(best[i]);
+    }
+    free(middle);
+    return F;
+}
+
+static char *commonPrefix(char *a, char *b)
+{
+    int n = 0;
+    char *s;
+    while (a[n] && a[n] == b[n])
+        n++;
+    s = malloc(n + 1);
+    memcpy(s, a, n);
+    s[n] = 0;
+    return s;
+}
+
+static char *commonSuffix(char *a, char *b)
+{
+    int na = strlen(a), nb = strlen(b), n = 0;
+    while (n < na && n < nb && a[na - n - 1] == b[nb - n - 1])
+        n++;
+    return strdup(a + na - n);
+}
+
+static factor *unionFactor(factor *A, factor *B)
+{
+    factor *F = malloc(sizeof(factor));
+    int i, j, n = 0;
+    char **req;
+    F->exact = A->exact && B->exact && !strcmp(A->exact, B->exact) ? strdup(A->exact) : NULL;
+    F->prefix = commonPrefix(A->prefix, B->prefix);
+    F->suffix = commonSuffix(A->suffix, B->suffix);
+    F->req = NULL;
+    F->nReq = 0;
+    if (!A->nReq || !B->nReq || A->nReq + B->nReq > MAX_LITERALS)
+        return F;
+    // union of both sets, without literals that contain another one
+    req = malloc((A->nReq + B->nReq) * sizeof(char *));
+    for (i = 0; i < A->nReq + B->nReq; i++)
+    {
+        char *s = i < A->nReq ? A->req[i] : B->req[i - A->nReq];
+        for (j = 0; j < n && !strstr(s, req[j]); j++)
+            ;
+        if (j < n)
+            continue;
+        for (j = 0; j < n; j++)
+            if (strstr(req[j], s))
+            {
+                free(req[j]);
+                req[j--] = req[--n];
+            }
+        req[n++] = strdup(s);
+    }
+    setRequired(F, req, n);
+    if (*F->prefix && betterRequired(&F->prefix, 1, F->req, F->nReq))
+        setRequired(F, singleLiteral(F->prefix), 1);
+    if (*F->suffix && betterRequired(&F->suffix, 1, F->req, F->nReq))
+        setRequired(F, singleLiteral(F->suffix), 1);
+    return F;
+}
+
+char **requiredLiterals(char *postfix, int *n)
+{
+    stack P = NULL;
+    factor *A, *B, *F;
+    char **req;
+    int i;
+    for (i = 0; postfix[i]; i++)
+    {
+        char c = postfix[i];
+        if (isAlphabet(c))
+            push(&P, symbolFactor(c));
+        else if (c == '*')
+        {
+            disposeFactor(pop(&P));
+            push(&P, kleeneFactor());
+        }
+        else if (c == '.' || c == '|')
+        {
+            B = pop(&P);
+            A = pop(&P);
+            push(&P, c == '.' ? concatFactor(A, B) : unionFactor(A, B));
+            disposeFactor(A);
+            disposeFactor(B);
+        }
+    }
+    F = pop(&P);
+    while (P)
+        disposeFactor(pop(&P));
+    *n = F->nReq;
+    req = F->req;
+    F->req = NULL;
+    F->nReq = 0;
+    disposeFactor(F);
+    return req;
+}
+
+//Prefilter Functions
+//-------------------
+
+prefilter *buildPrefilter(char **literals, int n)
+{
+    prefilter *P = malloc(sizeof(prefilter));
+    int i, j, c, size = 1, *fail, *queue, head = 0, tail = 0;
+    P->nLiterals = n;
+    P->literals = literals;
+    P->acStates = 0;
+    P->ac = NULL;
+    P->acFinal = NULL;
+    P->nFirst = 0;
+    if (n < 2)
+        return P;
+    for (i = 0; i < n && P->nFirst >= 0; i++)
+    {
+        for (j = 0; j < P->nFirst && P->first[j] != (unsigned char)literals[i][0]; j++)
+            ;
+        if (j == P->nFirst)
+            P->nFirst = P->nFirst < 4 ? P->nFirst + 1 : -1;
+        if (P->nFirst > 0)
+            P->first[j] = literals[i][0];
+    }
+    if (P->nFirst < 0)
+        P->nFirst = 0;
+    // Trie of the literals (-1 = no goto transition)
+    for (i = 0; i < n; i++)
+        size += strlen(literals[i]);
+    P->ac = malloc((size_t)size * 256 * sizeof(int));
+    P->acFinal = calloc(size, sizeof(unsigned char));
+    for (i = 0; i < size * 256; i++)
+        P->ac[i] = -1;
+    P->acStates = 1;
+    for (i = 0; i < n; i++)
+    {
+        int s = 0;
+        for (j = 0; literals[i][j]; j++)
+        {
+            c = (unsigned char)literals[i][j];
+            if (P->ac[s * 256 + c] < 0)
+                P->ac[s * 256 + c] = P->acStates++;
+            s = P->ac[s * 256 + c];
+        }
+        P->acFinal[s] = 1;
+    }
+    // Failure links in breadth first order, folded into the table
+    fail = calloc(P->acStates, sizeof(int));
+    queue = malloc(P->acStates * sizeof(int));
+    for (c = 0; c < 256; c++)
+        if (P->ac[c] < 0)
+            P->ac[c] = 0;
+        else
+            queue[tail++] = P->ac[c];
+    while (head < tail)
+    {
+        int s = queue[head++];
+        P->acFinal[s] |= P->acFinal[fail[s]];
+        for (c = 0; c < 256; c++)
+        {
+            int t = P->ac[s * 256 + c];
+            if (t < 0)
+                P->ac[s * 256 + c] = P->ac[fail[s] * 256 + c];
+            else
+            {
+                fail[t] = P->ac[fail[s] * 256 + c];
+                queue[tail++] = t;
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+    return P;
+}
+
+// first occurrence of lit: compares first and last bytes of 16
+// candidate positions at once, memcmp only on candidates
+static const char *findLiteral(const char *p, const char *end, const char *lit, size_t n)
+{
+    if (n == 1)
+        return memchr(p, lit[0], end - p);
+#ifdef __SSE2__
+    {
+        __m128i first = _mm_set1_epi8(lit[0]), last = _mm_set1_epi8(lit[n - 1]);
+        while (p + n - 1 + 16 <= end)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i *)p);
+            __m128i b = _mm_loadu_si128((const __m128i *)(p + n - 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+            while (mask)
+            {
+                int i = __builtin_ctz(mask);
+                if (!memcmp(p + i + 1, lit + 1, n - 2))
+                    return p + i;
+                mask &= mask - 1;
+            }
+            p += 16;
+        }
+    }
+#endif
+    while (p + n <= end && (p = memchr(p, lit[0], end - p - n + 1)))
+    {
+        if (!memcmp(p, lit, n))
+            return p;
+        p++;
+    }
+    return NULL;
+}
+
+// pointer to a byte of the first occurrence of any literal (or NULL)
+const char *findPrefilter(prefilter *P, const char *p, const char *end)
+{
+    int s = 0;
+    if (P->nLiterals == 1)
+        return findLiteral(p, end, P->literals[0], strlen(P->literals[0]));
+    for (; p < end; p++)
+    {
+        if (!s && P->nFirst && (p = findByteSet(p, end, P->first, P->nFirst)) == end)
+            break;
+        s = P->ac[s * 256 + (unsigned char)*p];
+        if (P->acFinal[s])
+            return p;
+    }
+    return NULL;
+}
+
+void displayPrefilter(prefilter *P)
+{
+    int i;
+    printf("\nRequired literals = [");
+    for (i = 0; i < P->nLiterals; i++)
+        printf("\"%s\"%s", P->literals[i], i < P->nLiterals - 1 ? "," : "");
+    printf("] (%s)\n", P->nLiterals > 1 ? "Aho-Corasick" : "memmem");
+}
+
+void disposePrefilter(prefilter *P)
+{
+    if (!P) return;
+    disposeLiterals(P->literals, P->nLiterals);
+    free(P->ac);
+    free(P->acFinal);
+    free(P);
+}
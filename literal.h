@@ -0,0 +1,16 @@
+#ifndef __LITERAL__
+#define __LITERAL__
+#include "structures.h"
+
+//Required Literal Functions
+//--------------------------
+char **requiredLiterals(char *, int *);
+
+//Prefilter Functions
+//-------------------
+prefilter *buildPrefilter(char **, int);
+const char *findPrefilter(prefilter *, const char *, const char *);
+void displayPrefilter(prefilter *);
+void disposePrefilter(prefilter *);
+
+#endif
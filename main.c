@@ -26,158 +26,845 @@
 #include "stack.h"
 #include "dfa.h"
 #include "nfa.h"
+#include "parse.h"
+#include "table.h"
+#include "comb.h"
+#include "lexer.h"
+#include "search.h"
+#include "cache.h"
+#include "literal.h"
+#include "sheng.h"
+#include "stride.h"
+#include "stream.h"
+#include "reader.h"
+#include "dict.h"
+#include "server.h"
+#include "refine.h"
+#include "ast.h"
+#include "equiv.h"
+#include "product.h"
 
-// functions to convert regex to regex in npr
-int prior(char c)
+char *readFile(char *name, size_t *size)
 {
-    switch (c)
+    FILE *file = fopen(name, "rb");
+    char *buffer;
+    long n;
+    if (!file)
     {
-    case '(':
-        return 1;
-    case '|':
-        return 2;
-    case '.':
-        return 3;
-    case '*':
-        return 4;
+        printf("File '%s' not found!\n", name);
+        exit(1);
     }
+    fseek(file, 0, SEEK_END);
+    n = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    buffer = malloc(n + 1);
+    *size = fread(buffer, 1, n, file);
+    buffer[*size] = 0;
+    fclose(file);
+    return buffer;
+}
+
+// scanning engines
+typedef int (*matchFunction)(void *, const char *, size_t);
+
+int matchCompact(void *T, const char *str, size_t n)
+{
+    return matchCompactTable(T, str, n);
 }
 
-void convert(char *infix, char *npr)
+int matchComb(void *T, const char *str, size_t n)
 {
-    char c, *stack = (char *)malloc(sizeof(char) * strlen(infix) + 1);
-    int i, j, top = -1;
-    for (j = 0, i = 0; infix[i]; i++)
+    return matchCombTable(T, str, n);
+}
+
+int matchSheng(void *T, const char *str, size_t n)
+{
+    return matchShengTable(T, str, n);
+}
+
+int matchStride(void *T, const char *str, size_t n)
+{
+    return matchStrideTable(T, str, n);
+}
+
+// prints the lines of the buffer fully matched by the automata
+// (with a prefilter only lines with a required literal are scanned)
+long scanLines(matchFunction match, void *T, prefilter *P, char *buffer, size_t size)
+{
+    char *line = buffer, *end = buffer + size;
+    long count = 0;
+    while (line < end)
     {
-        c = tolower(infix[i]);
-        if (isAlphabet(c))
-            npr[j++] = c;
-        else if (c == '|' || c == '.' || c == '*')
+        char *eol;
+        size_t n;
+        if (P)
         {
-            while (top >= 0 && prior(c) <= prior(stack[top]))
-                npr[j++] = stack[top--];
-            stack[++top] = c;
+            const char *hit = findPrefilter(P, line, end);
+            if (!hit)
+                break;
+            while (hit > line && hit[-1] != '\n')
+                hit--;
+            line = (char *)hit;
         }
-        else if (c == '(')
-            stack[++top] = c;
-        else if (c == ')')
+        eol = memchr(line, '\n', end - line);
+        n = eol ? eol - line : end - line;
+        if (match(T, line, n))
         {
-            while (top >= 0 && stack[top] != '(')
-                npr[j++] = stack[top--];
-            top--;
+            fwrite(line, 1, n, stdout);
+            putchar('\n');
+            count++;
         }
-        else
+        line += n + 1;
+    }
+    return count;
+}
+
+// same as scanLines, but groups of lines are matched in lockstep
+#define LINE_GROUP 1024
+long scanLinesBatch(compactTable *T, char *buffer, size_t size)
+{
+    const char *lines[LINE_GROUP];
+    size_t lens[LINE_GROUP];
+    int results[LINE_GROUP], i, n;
+    char *line = buffer, *end = buffer + size;
+    long count = 0;
+    while (line < end)
+    {
+        for (n = 0; n < LINE_GROUP && line < end; n++)
         {
-            printf("Symbol '%c' not allowed!\n", c);
-            exit(1);
+            char *eol = memchr(line, '\n', end - line);
+            lines[n] = line;
+            lens[n] = eol ? eol - line : end - line;
+            line += lens[n] + 1;
         }
+        matchCompactTableBatch(T, lines, lens, n, results);
+        for (i = 0; i < n; i++)
+            if (results[i])
+            {
+                fwrite(lines[i], 1, lens[i], stdout);
+                putchar('\n');
+                count++;
+            }
+    }
+    return count;
+}
+
+// profiles the lines of a file: visits per state (nStates) and per
+// transition (nStates * stride), returns the visits per state
+long *profileLines(compactTable *T, char *name)
+{
+    size_t size, n;
+    char *buffer = readFile(name, &size), *line = buffer, *end = buffer + size, *eol;
+    long *visits = calloc(T->nStates, sizeof(long));
+    long *counts = calloc((size_t)T->nStates * T->stride, sizeof(long));
+    for (; line < end; line += n + 1)
+    {
+        eol = memchr(line, '\n', end - line);
+        n = eol ? eol - line : end - line;
+        profileCompactTable(T, line, n, visits, counts);
+    }
+    displayProfile(T, visits, counts);
+    free(counts);
+    free(buffer);
+    return visits;
+}
+
+// engine used by -f: lockstep batch if B is set, else match on T
+typedef struct lineScanner
+{
+    matchFunction match;
+    void *T;
+    compactTable *B;
+    prefilter *P;
+} lineScanner;
+
+long scanRegion(lineScanner *L, char *buffer, size_t size)
+{
+    if (L->B)
+        return scanLinesBatch(L->B, buffer, size);
+    return scanLines(L->match, L->T, L->P, buffer, size);
+}
+
+// scans a file read by the chunk reader: whole lines are scanned in
+// place, only a line split between chunks is joined in carry
+long scanFile(lineScanner *L, FILE *file, size_t chunk)
+{
+    chunkReader *R = openChunkReader(file, READER_BUFFERS, chunk);
+    char *buffer, *carry = NULL;
+    size_t n, nCarry = 0, capacity = 0;
+    long count = 0;
+    if (!R)
+    {
+        printf("Cannot start the input reader!\n");
+        return -1;
+    }
+    while ((buffer = acquireChunk(R, &n)))
+    {
+        char *p = buffer, *end = buffer + n, *last = end;
+        char *eol = memchr(p, '\n', n);
+        if (nCarry || !eol)
+        {
+            size_t k = eol ? (size_t)(eol - p) : n;
+            if (nCarry + k > capacity)
+            {
+                capacity = 2 * (nCarry + k);
+                carry = realloc(carry, capacity);
+            }
+            memcpy(carry + nCarry, p, k);
+            nCarry += k;
+            if (!eol)
+            {
+                releaseChunk(R);
+                continue;
+            }
+            count += scanRegion(L, carry, nCarry);
+            nCarry = 0;
+            p = eol + 1;
+        }
+        while (last > p && last[-1] != '\n')
+            last--;
+        if (last > p)
+            count += scanRegion(L, p, last - p);
+        if (last < end)
+        {
+            if ((size_t)(end - last) > capacity)
+            {
+                capacity = 2 * (end - last);
+                carry = realloc(carry, capacity);
+            }
+            memcpy(carry, last, end - last);
+            nCarry = end - last;
+        }
+        releaseChunk(R);
+    }
+    if (nCarry)
+        count += scanRegion(L, carry, nCarry);
+    if (chunkReaderError(R))
+    {
+        printf("Cannot read the input!\n");
+        count = -1;
+    }
+    closeChunkReader(R);
+    free(carry);
+    return count;
+}
+
+// splits the buffer in lines (in place), skipping empty lines
+char **splitLines(char *buffer, int *n)
+{
+    char **lines = NULL, *line = buffer;
+    int capacity = 0;
+    *n = 0;
+    while (*line)
+    {
+        char *eol = strchr(line, '\n');
+        if (eol)
+            *eol = 0;
+        if (eol > line + 1 && eol[-1] == '\r')
+            eol[-1] = 0;
+        if (*line)
+        {
+            if (*n == capacity)
+            {
+                capacity = capacity ? 2 * capacity : 16;
+                lines = realloc(lines, capacity * sizeof(char *));
+            }
+            lines[(*n)++] = line;
+        }
+        if (!eol)
+            break;
+        line = eol + 1;
+    }
+    return lines;
+}
+
+// buffered output of tokens as "rule offset length" lines
+typedef struct output
+{
+    size_t n;
+    char buffer[1 << 16];
+} output;
+
+void flushOutput(output *out)
+{
+    fwrite(out->buffer, 1, out->n, stdout);
+    out->n = 0;
+}
+
+void putNumber(output *out, long v, char sep)
+{
+    char digits[24];
+    int i = 0;
+    if (v < 0)
+    {
+        out->buffer[out->n++] = '-';
+        v = -v;
+    }
+    do
+        digits[i++] = '0' + v % 10;
+    while (v /= 10);
+    while (i)
+        out->buffer[out->n++] = digits[--i];
+    out->buffer[out->n++] = sep;
+}
+
+void emitToken(token *tk, void *user)
+{
+    output *out = user;
+    if (out->n > sizeof(out->buffer) - 80)
+        flushOutput(out);
+    putNumber(out, tk->rule, ' ');
+    putNumber(out, tk->offset, ' ');
+    putNumber(out, tk->length, '\n');
+}
+
+void emitMatch(token *tk, void *user)
+{
+    output *out = user;
+    if (out->n > sizeof(out->buffer) - 80)
+        flushOutput(out);
+    putNumber(out, tk->offset, ' ');
+    putNumber(out, tk->length, '\n');
+}
+
+void emitMatchEnd(matchStream *st, void *user)
+{
+    output *out = user;
+    if (out->n > sizeof(out->buffer) - 80)
+        flushOutput(out);
+    putNumber(out, st->matchEnd, '\n');
+}
+
+// searches the standard input read by the chunk reader, the state of
+// the search is carried from one chunk to the next
+long searchInput(searcher *S, size_t chunk)
+{
+    chunkReader *R = openChunkReader(stdin, READER_BUFFERS, chunk);
+    output *out;
+    searchStream st;
+    char *buffer;
+    size_t n;
+    long count = 0;
+    if (!R)
+    {
+        printf("Cannot start the input reader!\n");
+        return -1;
     }
-    while (top >= 0)
-        npr[j++] = stack[top--];
-    npr[j] = '\0';
+    out = malloc(sizeof(output));
+    out->n = 0;
+    initSearchStream(&st, S);
+    while ((buffer = acquireChunk(R, &n)))
+    {
+        count += searchMatchStream(&st, S, buffer, n, emitMatchEnd, out);
+        releaseChunk(R);
+    }
+    count += finishSearchStream(&st, S, emitMatchEnd, out);
+    flushOutput(out);
+    free(out);
+    if (chunkReaderError(R))
+    {
+        printf("Cannot read the input!\n");
+        count = -1;
+    }
+    closeChunkReader(R);
+    return count;
 }
 
-void addDot(char *in, char *out)
+// alternation "w1|w2|...|wn" of the (non empty) lines of a word list
+char *readWords(char *name)
 {
-    int i, j;
-    out[0] = in[0];
-    for (i = 1, j = 1; in[i]; i++, j++)
+    size_t size, length = 0;
+    char *buffer = readFile(name, &size), **words, *regex;
+    int i, n;
+    words = splitLines(buffer, &n);
+    for (i = 0; i < n; i++)
+        length += strlen(words[i]) + 1;
+    regex = malloc(length + 1);
+    regex[0] = 0;
+    for (i = 0, length = 0; i < n; i++)
     {
-        if (in[i] == '(')
+        if (i)
+            regex[length++] = '|';
+        strcpy(regex + length, words[i]);
+        length += strlen(words[i]);
+    }
+    free(words);
+    free(buffer);
+    return regex;
+}
+
+// redfa lex <rules file> <input file> [-d] [-w n] [-j n]
+int lexMain(int argc, char **argv)
+{
+    char *rulesBuffer, *buffer, **rules;
+    size_t size;
+    int i, nRules, display = 0, threads = 1;
+    long window = 0;
+    lexer *X;
+    output *out;
+    if (argc < 4)
+    {
+        printf("\nUsage:%s lex <rules file> <input file> [Options]\n", argv[0]);
+        printf("\nOne regex per line of rules file (first rules have priority).\n");
+        printf("Prints \"rule offset length\" for each token (rule -1 = no match)\n");
+        printf("\nOptions:\n");
+        printf("\t-d\tDisplay lexer dfa\n");
+        printf("\t-w n\tScan at most n bytes beyond the last accept\n");
+        printf("\t-j n\tMinimize the lexer dfa with n threads\n");
+        return 1;
+    }
+    for (i = 4; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
         {
-            if (in[i - 1] != '.' && (isAlphabet(in[i - 1]) || in[i - 1] == ')' || in[i - 1] == '*'))
-                out[j++] = '.';
-            out[j] = in[i];
+            switch (argv[i][1])
+            {
+                case 'd': display = 1; break;
+                case 'w':
+                    if (i + 1 < argc)
+                        window = atol(argv[++i]);
+                    break;
+                case 'j':
+                    if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                        threads = atoi(argv[++i]);
+                    break;
+            }
         }
-        if (isAlphabet(in[i]))
+    }
+    rulesBuffer = readFile(argv[2], &size);
+    rules = splitLines(rulesBuffer, &nRules);
+    if (!nRules)
+    {
+        printf("No rules in '%s'!\n", argv[2]);
+        return 1;
+    }
+    if (!(X = buildLexer(rules, nRules, threads)))
+    {
+        printf("Invalid rule in '%s'!\n", argv[2]);
+        return 1;
+    }
+    X->maxLookahead = window;
+    if (display)
+        displayLexer(X, rules);
+    buffer = readFile(argv[3], &size);
+    out = malloc(sizeof(output));
+    out->n = 0;
+    lexBuffer(X, buffer, size, emitToken, out);
+    flushOutput(out);
+    free(out);
+    free(buffer);
+    free(rules);
+    free(rulesBuffer);
+    disposeLexer(X);
+    return 0;
+}
+
+// minimized dfa of a regex (NULL, with the error printed, if invalid)
+static dfa *regexDfa(char *regex)
+{
+    char *inputDot = malloc(2 * strlen(regex) + 2), *inputNPR = malloc(2 * strlen(regex) + 2);
+    dfa *D, *Dmin = NULL;
+    int error;
+    addDot(regex, inputDot);
+    if ((error = convert(inputDot, inputNPR)) != PARSE_OK)
+        printf("Invalid regex '%s': %s!\n", regex, parseError(error));
+    else if (literalAlternation(regex))
+    {
+        int nWords;
+        char **words = splitAlternation(regex, &nWords);
+        Dmin = buildDictionary(words, nWords);
+        free(words[0]);
+        free(words);
+    }
+    else
+    {
+        astTable *A = newAstTable();
+        astNode *root = buildAst(A, inputNPR);
+        if (root)
         {
-            if (in[i - 1] != '.' && (isAlphabet(in[i - 1]) || in[i - 1] == ')' || in[i - 1] == '*'))
-                out[j++] = '.';
-            out[j] = in[i];
+            nfa *N = astToReducedNfa(A, root);
+            D = nfaToDfa(N);
+            Dmin = minimize(D);
+            disposeNfaAutomata(N);
+            disposeDfaAutomata(D);
         }
         else
-            out[j] = in[i];
+            printf("Invalid regex '%s': %s!\n", regex, parseError(PARSE_OPERAND));
+        disposeAstTable(A);
+    }
+    free(inputDot);
+    free(inputNPR);
+    return Dmin;
+}
+
+// redfa equiv <regex A> <regex B>, redfa subset <regex A> <regex B>
+// exit status: 0 = equivalent (A subset of B), 1 = not, 2 = invalid regex
+int equivMain(int argc, char **argv)
+{
+    int subset = !strcmp(argv[1], "subset"), result;
+    char *witness = NULL;
+    dfa *A, *B;
+    if (argc < 4)
+    {
+        printf("\nUsage:%s %s <regex A> <regex B>\n", argv[0], argv[1]);
+        printf(subset ? "\nChecks that every string accepted by A is accepted by B\n"
+                      : "\nChecks that A and B accept the same strings\n");
+        printf("(else prints a shortest counterexample)\n");
+        return 2;
     }
-    out[j] = 0;
+    if (!(A = regexDfa(argv[2])) || !(B = regexDfa(argv[3])))
+        return 2;
+    result = subset ? includedDfa(A, B, &witness) : equivalentDfa(A, B, &witness);
+    if (result)
+        printf(subset ? "A is a subset of B\n" : "equivalent\n");
+    else
+        printf("%s: \"%s\" is accepted by %s only\n", subset ? "not a subset" : "not equivalent", witness,
+               acceptDfa(A, witness) ? "A" : "B");
+    free(witness);
+    disposeDfaAutomata(A);
+    disposeDfaAutomata(B);
+    return !result;
 }
 
 int main(int argc, char **argv)
 {
-    char *input, *inputDot, *inputNPR;
-    nfa *N;
-    dfa *D, *Dmin;
-    int display = 0, generate = 0, show = 0;
+    char *input, *inputDot, *inputNPR, *label;
+    nfa *N = NULL;
+    dfa *D = NULL, *Dmin = NULL;
+    compactTable *T = NULL;
+    combTable *C = NULL;
+    shengTable *K = NULL;
+    strideTable *W = NULL;
+    size_t strideSize = STRIDE_MAX_SIZE, chunk = READER_SIZE;
+    prefilter *P = NULL;
+    char *scanName = NULL, *searchName = NULL, *cacheDir = NULL, *profileName = NULL;
+    int display = 0, generate = 0, show = 0, table = 0, comb = 0, literals = 1, stride = 0, renumber = 0, reduce = 1;
+    int first = 2, error, threads = 1, dict = 0, product = 0;
+    if (argc > 1 && !strcmp(argv[1], "lex"))
+        return lexMain(argc, argv);
+    if (argc > 1 && !strcmp(argv[1], "serve"))
+        return serveMain(argc, argv);
+    if (argc > 1 && (!strcmp(argv[1], "equiv") || !strcmp(argv[1], "subset")))
+        return equivMain(argc, argv);
+    if (argc > 2 && !strcmp(argv[1], "dict"))
+    {
+        first = 3;
+        dict = 1;
+    }
+    if (argc > 3 && (!strcmp(argv[1], "inter") || !strcmp(argv[1], "diff")))
+    {
+        first = 4;
+        product = 1;
+    }
+    if (argc > 2 && !strcmp(argv[1], "comp"))
+    {
+        first = 3;
+        product = 1;
+    }
     if (argc < 2)
     {
         printf("Translate Regular Expression on Deterministic Finite Automata\n");
         printf("\nUsage:%s <RegEx> [Options]\n", argv[0]);
+        printf("      %s lex <rules file> <input file> [Options]\n", argv[0]);
+        printf("      %s dict <words file> [Options]\n", argv[0]);
+        printf("      %s serve <socket path> [-w workers]\n", argv[0]);
+        printf("      %s equiv|subset <regex A> <regex B>\n", argv[0]);
+        printf("      %s inter|diff <regex A> <regex B> [Options]\n", argv[0]);
+        printf("      %s comp <regex> [Options]\n", argv[0]);
         printf("\nwhere:");
         printf("\tRegex = Number or Letter or '|' or '*'\n");
         printf("\nOptions:\n");
         printf("\t-d\tDisplay dfa/nfa strutures\n");
         printf("\t-g\tCreate graph .dot files\n");
-        printf("\t-s\tShow set of corresponding dfa/nfa states\n");                
+        printf("\t-s\tShow set of corresponding dfa/nfa states\n");
+        printf("\t-t\tDisplay compact transition table\n");
+        printf("\t-z\tUse comb (row displacement) compressed table\n");
+        printf("\t-f file\tPrint lines of file (- = standard input) matched by the regex\n");
+        printf("\t-e file\tPrint offset and length of matches found in file\n");
+        printf("\t-e -\tPrint end offset of matches found in the standard input\n");
+        printf("\t-b n\tSize of the chunks read while scanning (-f, -e -)\n");
+        printf("\t-c dir\tLoad/store the minimized dfa in a cache directory\n");
+        printf("\t-p file\tProfile state visits over the lines of file\n");
+        printf("\t-r\tRenumber states by profile (-p) or breadth first\n");
+        printf("\t-x\tDo not skip lines without the required literals (-f)\n");
+        printf("\t-2\tConsume two bytes per transition (-f)\n");
+        printf("\t-m kb\tMaximum size of the two stride table (default %d)\n", STRIDE_MAX_SIZE / 1024);
+        printf("\t-j n\tMinimize with n threads\n");
+        printf("\t-n\tKeep the Thompson nfa (no simplification or reduction)\n");
         printf("\nExample: %s \"(a|b)*\" -d\n", argv[0]);
         input = malloc(10 * sizeof(char));
         strcpy(input, "(a|b)*");
+        label = input;
         display = 1;
     }
     else
     {
         int i;
-        for (i = 2; i < argc; i++) {
+        for (i = first; i < argc; i++) {
             if (argv[i][0] == '-') {
                 switch (argv[i][1]) {
                     case 'd': display = 1; break;
                     case 'g': generate = 1; break;
                     case 's': show = 1; break;
+                    case 't': table = 1; break;
+                    case 'z': comb = 1; break;
+                    case 'x': literals = 0; break;
+                    case '2': stride = 1; break;
+                    case 'r': renumber = 1; break;
+                    case 'n': reduce = 0; break;
+                    case 'p':
+                        if (i + 1 < argc)
+                            profileName = argv[++i];
+                        break;
+                    case 'b':
+                        if (i + 1 < argc && atol(argv[i + 1]) > 0)
+                            chunk = atol(argv[++i]);
+                        break;
+                    case 'j':
+                        if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+                            threads = atoi(argv[++i]);
+                        break;
+                    case 'm':
+                        if (i + 1 < argc)
+                            strideSize = (size_t)atol(argv[++i]) * 1024;
+                        break;
+                    case 'f':
+                        if (i + 1 < argc)
+                            scanName = argv[++i];
+                        break;
+                    case 'e':
+                        if (i + 1 < argc)
+                            searchName = argv[++i];
+                        break;
+                    case 'c':
+                        if (i + 1 < argc)
+                            cacheDir = argv[++i];
+                        break;
                 }
             }
         }
-        input = malloc(sizeof(argv[1]) * sizeof(char) + 1);
-        strcpy(input, argv[1]);
+        if (dict) {
+            // dictionary: alternation of the words in the file
+            input = readWords(argv[2]);
+            label = argv[2];
+        }
+        else if (product) {
+            // every match is a match of A: its literals still hold
+            input = malloc(strlen(argv[2]) * sizeof(char) + 1);
+            strcpy(input, argv[2]);
+            label = malloc(strlen(argv[2]) + (first == 4 ? strlen(argv[3]) : 0) + 8);
+            if (first == 4)
+                sprintf(label, "(%s)%s(%s)", argv[2], !strcmp(argv[1], "inter") ? "&" : "-", argv[3]);
+            else
+                sprintf(label, "!(%s)", argv[2]);
+            if (first == 3)
+                literals = 0;
+            cacheDir = NULL;
+        }
+        else {
+            input = malloc(strlen(argv[1]) * sizeof(char) + 1);
+            strcpy(input, argv[1]);
+            label = input;
+        }
     }
 
     // Regex convertion
-    inputDot = malloc(2 * strlen(input) * sizeof(char));
-    inputNPR = malloc(2 * strlen(input) * sizeof(char));
+    inputDot = malloc(2 * strlen(input) * sizeof(char) + 2);
+    inputNPR = malloc(2 * strlen(input) * sizeof(char) + 2);
     addDot(input, inputDot);
-    convert(inputDot, inputNPR);
+    if ((error = convert(inputDot, inputNPR)) != PARSE_OK)
+    {
+        printf("Invalid regex: %s!\n", parseError(error));
+        exit(1);
+    }
+
+    // Product of the minimized dfas (only the reachable pairs)
+    if (product)
+    {
+        dfa *A = regexDfa(argv[2]), *B = NULL;
+        if (!A || (first == 4 && !(B = regexDfa(argv[3]))))
+            exit(1);
+        if (B)
+            D = productDfa(A, B, !strcmp(argv[1], "inter") ? PRODUCT_INTERSECTION : PRODUCT_DIFFERENCE);
+        else
+            D = complementDfa(A);
+        Dmin = minimizeParallel(D, threads);
+        disposeDfaAutomata(A);
+        disposeDfaAutomata(B);
+    }
 
-    // NFA and DFA convertions
-    N = regexToNfa(inputNPR);
-    D = nfaToDfa(N);
-    Dmin = minimize(D);
+    // NFA and DFA convertions (or minimized DFA from cache)
+    if (cacheDir)
+        Dmin = loadCachedDfa(cacheDir, inputNPR);
+    if (!Dmin && literalAlternation(input))
+    {
+        // w1|w2|...|wn: minimal dfa built straight from the words
+        int nWords;
+        char **words = splitAlternation(input, &nWords);
+        Dmin = buildDictionary(words, nWords);
+        free(words[0]);
+        free(words);
+        if (cacheDir && !saveCachedDfa(cacheDir, inputNPR, Dmin))
+            printf("Cannot write cache in '%s'!\n", cacheDir);
+    }
+    if (!Dmin)
+    {
+        astTable *A = newAstTable();
+        astNode *root = reduce ? buildAst(A, inputNPR) : NULL;
+        if (root)
+            N = astToReducedNfa(A, root);
+        else if (reduce || !(N = regexToNfa(inputNPR)))
+        {
+            printf("Invalid regex: %s!\n", parseError(PARSE_OPERAND));
+            exit(1);
+        }
+        disposeAstTable(A);
+        D = nfaToDfa(N);
+        Dmin = minimizeParallel(D, threads);
+        if (cacheDir && !saveCachedDfa(cacheDir, inputNPR, Dmin))
+            printf("Cannot write cache in '%s'!\n", cacheDir);
+    }
+    if (literals)
+    {
+        int nLiterals;
+        char **required = requiredLiterals(inputNPR, &nLiterals);
+        if (nLiterals)
+            P = buildPrefilter(required, nLiterals);
+        else
+            free(required);
+    }
+    if (profileName || renumber)
+    {
+        long *visits = NULL;
+        if (profileName)
+        {
+            compactTable *Tp = buildCompactTable(Dmin);
+            visits = profileLines(Tp, profileName);
+            disposeCompactTable(Tp);
+        }
+        if (renumber)
+        {
+            // hot states first, so their rows share a few cache lines
+            dfa *R = renumberDfa(Dmin, visits);
+            disposeDfaAutomata(Dmin);
+            Dmin = R;
+        }
+        free(visits);
+    }
+    if (comb)
+        C = buildCombTable(Dmin);
+    else
+    {
+        T = buildCompactTable(Dmin);
+        K = buildShengTable(T); // small automata: shuffle based engine
+        if (stride && !(W = buildStrideTable(T, strideSize)))
+            fprintf(stderr, "Two stride table larger than %lu KB, using one byte steps\n", (unsigned long)strideSize / 1024);
+    }
 
     if (display) {
-       displayNfaAutomata(N, input);    
-       displayDfaAutomata(D, input);
-       displayDfaAutomata(Dmin, input);
+       if (N)
+          displayNfaAutomata(N, label);
+       if (D) {
+          classifyDfa(D); // only the minimized dfas are classified
+          displayDfaAutomata(D, label);
+       }
+       displayDfaAutomata(Dmin, label);
+       if (P)
+          displayPrefilter(P);
+    }
+
+    if (table && comb)
+       displayCombTable(C);
+    else if (table) {
+       displayCompactTable(T);
+       if (W)
+          displayStrideTable(W);
+       else if (K)
+          printf("engine   = sheng (pshufb, %d states)\n", K->nStates);
+    }
+
+    if (scanName) {
+       lineScanner L = {matchCompact, T, NULL, P};
+       FILE *file = strcmp(scanName, "-") ? fopen(scanName, "rb") : stdin;
+       if (!file) {
+          printf("File '%s' not found!\n", scanName);
+          exit(1);
+       }
+       if (comb) {
+          L.match = matchComb;
+          L.T = C;
+       }
+       else if (W) {
+          L.match = matchStride;
+          L.T = W;
+       }
+       else if (K) {
+          L.match = matchSheng;
+          L.T = K;
+       }
+       else if (!P)
+          L.B = T;
+       long count = scanFile(&L, file, chunk);
+       if (file != stdin)
+          fclose(file);
+       if (count < 0)
+          exit(1);
     }
 
     if (generate) {
-       // NFA dot and png files generation
-       saveNfaDotFile(N, "afn.dot", input);
-       system("dot -Tpng afn.dot -o afn.png");
-       system("eog afn.png&");
+       if (N) {
+          // NFA dot and png files generation
+          saveNfaDotFile(N, "afn.dot", label);
+          system("dot -Tpng afn.dot -o afn.png");
+          system("eog afn.png&");
+       }
 
-       // DFA dot and png files generation
-       saveDfaDotFile(D, "afd.dot", input, show);
-       system("dot -Tpng afd.dot -o afd.png");
-       system("eog afd.png&");
+       if (D) {
+          // DFA dot and png files generation
+          saveDfaDotFile(D, "afd.dot", label, show);
+          system("dot -Tpng afd.dot -o afd.png");
+          system("eog afd.png&");
+       }
 
        //DFA minimal dot and png files generation
-       saveDfaDotFile(Dmin, "afdmin.dot", input, show);
+       saveDfaDotFile(Dmin, "afdmin.dot", label, show);
        system("dot -Tpng afdmin.dot -o afdmin.png");
        system("eog afdmin.png&");
     }
 
+    if (searchName && !strcmp(searchName, "-")) {
+       searcher *S = buildSearcher(Dmin);
+       long count = searchInput(S, chunk);
+       disposeSearcher(S);
+       if (count < 0)
+          exit(1);
+    }
+    else if (searchName) {
+       size_t size;
+       char *buffer = readFile(searchName, &size);
+       searcher *S = buildSearcher(Dmin);
+       output *out = malloc(sizeof(output));
+       out->n = 0;
+       searchBuffer(S, buffer, size, emitMatch, out);
+       flushOutput(out);
+       free(out);
+       disposeSearcher(S);
+       free(buffer);
+    }
+
     disposeNfaAutomata(N);
     disposeDfaAutomata(D);
     disposeDfaAutomata(Dmin);
+    disposeCompactTable(T);
+    disposeCombTable(C);
+    disposeShengTable(K);
+    disposeStrideTable(W);
+    disposePrefilter(P);
     free(input);
     free(inputDot);
     free(inputNPR);
+    if (product)
+        free(label);
 
     return 0;
 }
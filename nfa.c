@@ -137,6 +137,35 @@ nfa *buildConcat(nfa *A, nfa *B)
     return newA;
 }
 
+// n-ary union: s0 -e-> each operand, each operand final -e-> last state
+nfa *buildAlternation(nfa **A, int n)
+{
+    int i, k, offset;
+    nfa *newA = malloc(sizeof(nfa));
+    newA->nStates = 2;
+    for (k = 0; k < n; k++)
+        newA->nStates += A[k]->nStates;
+    newA->transitions = malloc(newA->nStates * sizeof(link *));
+    for (i = 0; i < newA->nStates; i++)
+        newA->transitions[i] = NULL;
+    for (k = n - 1, offset = newA->nStates - 1; k >= 0; k--)
+    {
+        offset -= A[k]->nStates;
+        insertLink(newA->transitions + 0, EPSILON, offset);
+        for (i = 0; i < A[k]->nStates; i++)
+        {
+            link *L = A[k]->transitions[i];
+            while (L)
+            {
+                insertLink(newA->transitions + offset + i, L->symbol, L->state + offset);
+                L = L->next;
+            }
+        }
+        insertLink(newA->transitions + offset + A[k]->nStates - 1, EPSILON, newA->nStates - 1);
+    }
+    return newA;
+}
+
 void disposeNfaAutomata(nfa *A)
 {
     int i;
@@ -201,6 +230,8 @@ nfa *regexToNfa(char *regex)
             A = buildSymbol(c);
             push(&P, A);
         }
+        if ((c == '*' || c == '.' || c == '|') && (!P || (c != '*' && !P->next)))
+            break; // missing operand
         if (c == '*')
         {
             A = pop(&P);
@@ -227,7 +258,11 @@ nfa *regexToNfa(char *regex)
             disposeNfaAutomata(B);
         }
     }
-    return pop(&P);
+    // well formed: one automaton left and the whole regex read
+    A = !regex[i] && P && !P->next ? pop(&P) : NULL;
+    while (P)
+        disposeNfaAutomata(pop(&P));
+    return A;
 }
 
 void saveNfaDotFile(nfa *A, char *name, char *regex)
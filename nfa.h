@@ -10,6 +10,7 @@ nfa *buildSymbol(char);
 nfa *buildKleene(nfa *);
 nfa *buildUnion(nfa *, nfa *);
 nfa *buildConcat(nfa *, nfa *);
+nfa *buildAlternation(nfa **, int);
 void disposeNfaAutomata(nfa *);
 void displayNfaAutomata(nfa *, char *);
 int isAlphabet(char);
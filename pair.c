@@ -0,0 +1,76 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "pair.h"
+#include "dfa.h"
+
+//DFA Pair Functions
+//------------------
+//  Pairs (p of A, q of B) of two dfas read the same symbols of a common
+//  vocabulary: equivalence and inclusion explore them, products build
+//  a dfa of them
+
+void initPairOperand(pairOperand *O, dfa *D, char *sigma)
+{
+    dfaState *st;
+    int i, j;
+    O->D = D;
+    O->n = D->nStates;
+    O->initial = initialState(D);
+    O->final = calloc(O->n + 1, sizeof(char));
+    O->kind = malloc(O->n + 1);
+    for (i = 0, st = D->states; st; i++, st = st->next)
+    {
+        O->final[i] = st->final;
+        O->kind[i] = st->kind;
+    }
+    O->kind[O->n] = STATE_DEAD;
+    O->column = malloc(strlen(sigma) * sizeof(int));
+    O->complete = 1;
+    for (i = 0; sigma[i]; i++)
+    {
+        for (j = 0; j < D->nSymbols && D->sigma[j] != sigma[i]; j++)
+            ;
+        O->column[i] = j < D->nSymbols ? j : -1;
+        O->complete &= j < D->nSymbols;
+    }
+}
+
+// state reached from s by symbol c of the common vocabulary
+int stepPairOperand(pairOperand *O, int s, int c)
+{
+    if (s == O->n || O->column[c] < 0)
+        return O->n;
+    return O->D->transitions[s * O->D->nSymbols + O->column[c]];
+}
+
+void disposePairOperand(pairOperand *O)
+{
+    free(O->final);
+    free(O->kind);
+    free(O->column);
+}
+
+// slot of the pair in an open addressing table of mask + 1 slots
+size_t hashPair(int p, int q, size_t mask)
+{
+    return (((size_t)p * 2654435761u) ^ ((size_t)q * 40503u)) & mask;
+}
@@ -0,0 +1,12 @@
+#ifndef __PAIR__
+#define __PAIR__
+#include "structures.h"
+
+//DFA Pair Functions
+//------------------
+void initPairOperand(pairOperand *, dfa *, char *);
+int stepPairOperand(pairOperand *, int, int);
+void disposePairOperand(pairOperand *);
+size_t hashPair(int, int, size_t);
+
+#endif
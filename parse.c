@@ -0,0 +1,154 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ * 
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "parse.h"
+#include "nfa.h"
+#include "reduce.h"
+#include "ast.h"
+
+// functions to convert regex to regex in npr
+int prior(char c)
+{
+    switch (c)
+    {
+    case '(':
+        return 1;
+    case '|':
+        return 2;
+    case '.':
+        return 3;
+    case '*':
+        return 4;
+    }
+}
+
+// infix (with explicit '.') to postfix: PARSE_OK or the error found
+int convert(char *infix, char *npr)
+{
+    char c, *stack = (char *)malloc(sizeof(char) * strlen(infix) + 1);
+    int i, j, top = -1, error = PARSE_OK;
+    for (j = 0, i = 0; infix[i]; i++)
+    {
+        c = tolower(infix[i]);
+        if (isAlphabet(c))
+            npr[j++] = c;
+        else if (c == '|' || c == '.' || c == '*')
+        {
+            while (top >= 0 && prior(c) <= prior(stack[top]))
+                npr[j++] = stack[top--];
+            stack[++top] = c;
+        }
+        else if (c == '(')
+            stack[++top] = c;
+        else if (c == ')')
+        {
+            while (top >= 0 && stack[top] != '(')
+                npr[j++] = stack[top--];
+            if (top < 0)
+            {
+                error = PARSE_PARENTHESIS;
+                break;
+            }
+            top--;
+        }
+        else
+        {
+            error = PARSE_SYMBOL;
+            break;
+        }
+    }
+    while (top >= 0 && !error)
+        if ((npr[j++] = stack[top--]) == '(')
+            error = PARSE_PARENTHESIS;
+    npr[j] = '\0';
+    free(stack);
+    return error;
+}
+
+const char *parseError(int error)
+{
+    switch (error)
+    {
+    case PARSE_OK:
+        return "no error";
+    case PARSE_SYMBOL:
+        return "symbol not allowed (use letters, digits, '|', '*' and parentheses)";
+    case PARSE_PARENTHESIS:
+        return "unbalanced parentheses";
+    default:
+        return "operator without operand";
+    }
+}
+
+void addDot(char *in, char *out)
+{
+    int i, j;
+    out[0] = in[0];
+    for (i = 1, j = 1; in[0] && in[i]; i++, j++)
+    {
+        if (in[i] == '(')
+        {
+            if (in[i - 1] != '.' && (isAlphabet(in[i - 1]) || in[i - 1] == ')' || in[i - 1] == '*'))
+                out[j++] = '.';
+            out[j] = in[i];
+        }
+        if (isAlphabet(in[i]))
+        {
+            if (in[i - 1] != '.' && (isAlphabet(in[i - 1]) || in[i - 1] == ')' || in[i - 1] == '*'))
+                out[j++] = '.';
+            out[j] = in[i];
+        }
+        else
+            out[j] = in[i];
+    }
+    out[j] = 0;
+}
+
+// tree of the regex in the table (NULL if invalid)
+astNode *parseAst(astTable *A, char *regex)
+{
+    char *inputDot = malloc(2 * strlen(regex) * sizeof(char) + 2);
+    char *inputNPR = malloc(2 * strlen(regex) * sizeof(char) + 2);
+    astNode *x = NULL;
+    addDot(regex, inputDot);
+    if (convert(inputDot, inputNPR) == PARSE_OK)
+        x = buildAst(A, inputNPR);
+    free(inputDot);
+    free(inputNPR);
+    return x;
+}
+
+// reduced nfa of the tree
+nfa *astToReducedNfa(astTable *A, astNode *x)
+{
+    nfa *N = astToNfa(A, x), *M = reduceNfa(N);
+    disposeNfaAutomata(N);
+    return M;
+}
+
+nfa *parseRegex(char *regex)
+{
+    astTable *A = newAstTable();
+    astNode *x = parseAst(A, regex);
+    nfa *N = x ? astToReducedNfa(A, x) : NULL;
+    disposeAstTable(A);
+    return N;
+}
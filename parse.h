@@ -0,0 +1,15 @@
+#ifndef __PARSE__
+#define __PARSE__
+#include "structures.h"
+
+//Regex Parsing Functions
+//-----------------------
+int prior(char);
+int convert(char *, char *);
+const char *parseError(int);
+void addDot(char *, char *);
+astNode *parseAst(astTable *, char *);
+nfa *astToReducedNfa(astTable *, astNode *);
+nfa *parseRegex(char *);
+
+#endif
@@ -0,0 +1,229 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "product.h"
+#include "dfa.h"
+#include "nfa.h"
+#include "pair.h"
+
+//DFA Product Functions
+//---------------------
+//  Only the pairs (p of A, q of B) reached from the initial pair are
+//  built, breadth first. A pair that can no longer accept is not
+//  explored: every such pair is the same dead state
+//    intersection: p or q dead          difference: p dead or q accept sink
+//  (a sink of B is one only if B reads every symbol of the product)
+//  A symbol outside the vocabulary of A or B leads to its dead state
+//  (pairOperand).
+
+static int deadPair(pairOperand *A, pairOperand *B, int p, int q, int op)
+{
+    if (A->kind[p] == STATE_DEAD)
+        return 1;
+    if (op == PRODUCT_INTERSECTION)
+        return B->kind[q] == STATE_DEAD;
+    return B->kind[q] == STATE_SINK && B->complete;
+}
+
+// pairs[2 * i], pairs[2 * i + 1] = p, q of state i; dead = -1, -1
+typedef struct pairIndex
+{
+    size_t n;
+    size_t capacity;
+    int *pairs;
+    size_t tableSize;
+    int *table;
+} pairIndex;
+
+static void rehashPairs(pairIndex *I)
+{
+    size_t i, mask;
+    free(I->table);
+    I->tableSize *= 2;
+    mask = I->tableSize - 1;
+    I->table = malloc(I->tableSize * sizeof(int));
+    memset(I->table, -1, I->tableSize * sizeof(int));
+    for (i = 0; i < I->n; i++)
+    {
+        size_t h = hashPair(I->pairs[2 * i], I->pairs[2 * i + 1], mask);
+        while (I->table[h] >= 0)
+            h = (h + 1) & mask;
+        I->table[h] = i;
+    }
+}
+
+// state of the pair, added (and queued, as the last one) if new
+static int pairState(pairIndex *I, int p, int q)
+{
+    size_t mask = I->tableSize - 1, h = hashPair(p, q, mask);
+    while (I->table[h] >= 0)
+    {
+        int s = I->table[h];
+        if (I->pairs[2 * s] == p && I->pairs[2 * s + 1] == q)
+            return s;
+        h = (h + 1) & mask;
+    }
+    if (I->n == I->capacity)
+    {
+        I->capacity *= 2;
+        I->pairs = realloc(I->pairs, 2 * I->capacity * sizeof(int));
+    }
+    I->pairs[2 * I->n] = p;
+    I->pairs[2 * I->n + 1] = q;
+    I->table[h] = I->n++;
+    if (2 * I->n > I->tableSize)
+        rehashPairs(I);
+    return I->n - 1;
+}
+
+static dfa *newDfa(char *sigma, int nStates, int *transitions, char *final)
+{
+    dfa *D = malloc(sizeof(dfa));
+    dfaState *tail = NULL;
+    int i;
+    D->nSymbols = strlen(sigma);
+    D->sigma = sigma;
+    D->nStates = nStates;
+    D->transitions = transitions;
+    D->states = NULL;
+    for (i = 0; i < nStates; i++)
+    {
+        dfaState *st = malloc(sizeof(dfaState));
+        st->final = final[i];
+        st->initial = !i;
+        st->kind = STATE_LIVE;
+        st->stateSet = NULL;
+        st->next = NULL;
+        if (tail)
+            tail->next = st;
+        else
+            D->states = st;
+        tail = st;
+    }
+    return D;
+}
+
+// dfa of the strings accepted by A and B (op = PRODUCT_INTERSECTION) or
+// by A and not by B (PRODUCT_DIFFERENCE), not minimized
+dfa *productDfa(dfa *A, dfa *B, int op)
+{
+    pairOperand OA, OB;
+    pairIndex I;
+    dfa *D;
+    char *sigma = malloc(A->nSymbols + 1), *final;
+    int *transitions, nSymbols = 0, c, s, capacity = 64;
+    size_t head;
+    // intersection: common symbols only, difference: symbols of A
+    for (c = 0; c < A->nSymbols; c++)
+        if (op == PRODUCT_DIFFERENCE || memchr(B->sigma, A->sigma[c], B->nSymbols))
+            sigma[nSymbols++] = A->sigma[c];
+    sigma[nSymbols] = 0;
+    initPairOperand(&OA, A, sigma);
+    initPairOperand(&OB, B, sigma);
+    I.n = 0;
+    I.capacity = 64;
+    I.pairs = malloc(2 * I.capacity * sizeof(int));
+    I.tableSize = 128;
+    I.table = malloc(I.tableSize * sizeof(int));
+    memset(I.table, -1, I.tableSize * sizeof(int));
+    transitions = malloc((size_t)capacity * (nSymbols ? nSymbols : 1) * sizeof(int));
+    final = malloc(capacity);
+    s = initialState(A);
+    c = initialState(B);
+    if (deadPair(&OA, &OB, s, c, op))
+        pairState(&I, -1, -1);
+    else
+        pairState(&I, s, c);
+    for (head = 0; head < I.n; head++)
+    {
+        int p = I.pairs[2 * head], q = I.pairs[2 * head + 1];
+        if (head == (size_t)capacity)
+        {
+            capacity *= 2;
+            transitions = realloc(transitions, (size_t)capacity * (nSymbols ? nSymbols : 1) * sizeof(int));
+            final = realloc(final, capacity);
+        }
+        if (p < 0)
+        {
+            // the dead pair loops on every symbol
+            final[head] = 0;
+            for (c = 0; c < nSymbols; c++)
+                transitions[head * nSymbols + c] = head;
+            continue;
+        }
+        final[head] = OA.final[p] && (op == PRODUCT_INTERSECTION ? OB.final[q] : !OB.final[q]);
+        for (c = 0; c < nSymbols; c++)
+        {
+            int p1 = stepPairOperand(&OA, p, c), q1 = stepPairOperand(&OB, q, c);
+            if (deadPair(&OA, &OB, p1, q1, op))
+                p1 = q1 = -1;
+            transitions[head * nSymbols + c] = pairState(&I, p1, q1);
+        }
+    }
+    disposePairOperand(&OA);
+    disposePairOperand(&OB);
+    free(I.pairs);
+    free(I.table);
+    D = newDfa(sigma, I.n, transitions, final);
+    free(final);
+    return D;
+}
+
+// dfa of the strings over the whole alphabet ([a-z0-9]) not accepted
+// by A: finals swapped, symbols outside sigma go to an accepting state
+dfa *complementDfa(dfa *A)
+{
+    char *sigma = malloc(37), *final;
+    int *transitions, *column = malloc(37 * sizeof(int)), *id;
+    int nSymbols = 0, n = A->nStates + 1, init = initialState(A), c, i, j;
+    dfaState *st;
+    dfa *D;
+    for (c = 1; c < 256; c++)
+        if (isAlphabet(c))
+            sigma[nSymbols++] = c;
+    sigma[nSymbols] = 0;
+    for (i = 0; i < nSymbols; i++)
+    {
+        for (j = 0; j < A->nSymbols && A->sigma[j] != sigma[i]; j++)
+            ;
+        column[i] = j < A->nSymbols ? j : -1;
+    }
+    // the initial state goes first (newDfa marks state 0 initial)
+    transitions = malloc((size_t)n * nSymbols * sizeof(int));
+    final = malloc(n);
+    id = malloc(n * sizeof(int));
+    for (i = 0, j = 1; i < A->nStates; i++)
+        id[i] = i == init ? 0 : j++;
+    for (i = 0, st = A->states; st; i++, st = st->next)
+    {
+        final[id[i]] = !st->final;
+        for (c = 0; c < nSymbols; c++)
+            transitions[id[i] * nSymbols + c] = column[c] < 0 ? n - 1 : id[A->transitions[i * A->nSymbols + column[c]]];
+    }
+    final[n - 1] = 1;
+    for (c = 0; c < nSymbols; c++)
+        transitions[(n - 1) * nSymbols + c] = n - 1;
+    free(id);
+    free(column);
+    D = newDfa(sigma, n, transitions, final);
+    free(final);
+    return D;
+}
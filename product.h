@@ -0,0 +1,10 @@
+#ifndef __PRODUCT__
+#define __PRODUCT__
+#include "structures.h"
+
+//DFA Product Functions
+//---------------------
+dfa *productDfa(dfa *, dfa *, int);
+dfa *complementDfa(dfa *);
+
+#endif
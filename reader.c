@@ -0,0 +1,155 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "reader.h"
+
+//Chunk Reader Functions
+//----------------------
+//  Reading and scanning overlap: while the dfa scans one buffer the
+//  reader thread fills the next ones, so the time is close to the
+//  slower of the two instead of their sum
+
+static void *readChunks(void *arg)
+{
+    chunkReader *R = arg;
+    for (;;)
+    {
+        size_t n;
+        pthread_mutex_lock(&R->lock);
+        while (R->count == R->nBuffers && !R->stop)
+            pthread_cond_wait(&R->emptied, &R->lock);
+        if (R->stop)
+        {
+            pthread_mutex_unlock(&R->lock);
+            break;
+        }
+        pthread_mutex_unlock(&R->lock);
+        // only this thread touches buffers[tail] until count grows
+        n = fread(R->buffers[R->tail], 1, R->size, R->file);
+        pthread_mutex_lock(&R->lock);
+        if (n)
+        {
+            R->lengths[R->tail] = n;
+            R->tail = (R->tail + 1) % R->nBuffers;
+            R->count++;
+        }
+        else
+        {
+            R->eof = 1;
+            R->error = ferror(R->file);
+        }
+        pthread_cond_signal(&R->filled);
+        pthread_mutex_unlock(&R->lock);
+        if (!n)
+            break;
+    }
+    return NULL;
+}
+
+// ring of nBuffers buffers of size bytes (NULL if the buffers cannot be
+// allocated or the thread not started)
+chunkReader *openChunkReader(FILE *file, int nBuffers, size_t size)
+{
+    chunkReader *R = malloc(sizeof(chunkReader));
+    int i, ok;
+    if (!R)
+        return NULL;
+    R->file = file;
+    R->nBuffers = nBuffers;
+    R->size = size;
+    R->buffers = calloc(nBuffers, sizeof(char *));
+    R->lengths = calloc(nBuffers, sizeof(size_t));
+    ok = R->buffers && R->lengths;
+    for (i = 0; ok && i < nBuffers; i++)
+        ok = (R->buffers[i] = aligned_alloc(READER_ALIGN, (size + READER_ALIGN - 1) / READER_ALIGN * READER_ALIGN)) != NULL;
+    R->head = R->tail = R->count = 0;
+    R->eof = R->error = R->stop = 0;
+    pthread_mutex_init(&R->lock, NULL);
+    pthread_cond_init(&R->filled, NULL);
+    pthread_cond_init(&R->emptied, NULL);
+    if (!ok || pthread_create(&R->thread, NULL, readChunks, R))
+    {
+        R->stop = 1;
+        closeChunkReader(R);
+        return NULL;
+    }
+    return R;
+}
+
+// next filled buffer in file order (NULL at the end of the file); it
+// stays valid until releaseChunk
+char *acquireChunk(chunkReader *R, size_t *n)
+{
+    char *buffer = NULL;
+    pthread_mutex_lock(&R->lock);
+    while (!R->count && !R->eof)
+        pthread_cond_wait(&R->filled, &R->lock);
+    if (R->count)
+    {
+        buffer = R->buffers[R->head];
+        *n = R->lengths[R->head];
+    }
+    pthread_mutex_unlock(&R->lock);
+    return buffer;
+}
+
+// nonzero if the reader stopped on a read error instead of the end of
+// the file (once acquireChunk returned NULL)
+int chunkReaderError(chunkReader *R)
+{
+    int error;
+    pthread_mutex_lock(&R->lock);
+    error = R->error;
+    pthread_mutex_unlock(&R->lock);
+    return error;
+}
+
+// gives the acquired buffer back to the reader
+void releaseChunk(chunkReader *R)
+{
+    pthread_mutex_lock(&R->lock);
+    R->head = (R->head + 1) % R->nBuffers;
+    R->count--;
+    pthread_cond_signal(&R->emptied);
+    pthread_mutex_unlock(&R->lock);
+}
+
+void closeChunkReader(chunkReader *R)
+{
+    int i;
+    if (!R) return;
+    if (!R->stop)
+    {
+        pthread_mutex_lock(&R->lock);
+        R->stop = 1;
+        pthread_cond_signal(&R->emptied);
+        pthread_mutex_unlock(&R->lock);
+        pthread_join(R->thread, NULL);
+    }
+    pthread_mutex_destroy(&R->lock);
+    pthread_cond_destroy(&R->filled);
+    pthread_cond_destroy(&R->emptied);
+    for (i = 0; R->buffers && i < R->nBuffers; i++)
+        free(R->buffers[i]);
+    free(R->buffers);
+    free(R->lengths);
+    free(R);
+}
@@ -0,0 +1,13 @@
+#ifndef __READER__
+#define __READER__
+#include "structures.h"
+
+//Chunk Reader Functions
+//----------------------
+chunkReader *openChunkReader(FILE *, int, size_t);
+char *acquireChunk(chunkReader *, size_t *);
+void releaseChunk(chunkReader *);
+int chunkReaderError(chunkReader *);
+void closeChunkReader(chunkReader *);
+
+#endif
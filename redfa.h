@@ -0,0 +1,61 @@
+#ifndef __REDFA__
+#define __REDFA__
+
+#include <stddef.h>
+#include <stdint.h>
+
+//redfa Library Interface
+//-----------------------
+//  A compiled regex is immutable: any number of threads may match with
+//  it at the same time. Compiling shares no state either, so threads may
+//  compile concurrently. Functions return errors instead of exiting.
+//
+//  Regex = letters, digits, '|' (union), '*' (kleene closure), parentheses
+
+#if defined(__GNUC__)
+#define REDFA_API __attribute__((visibility("default")))
+#else
+#define REDFA_API
+#endif
+
+// errors (same values as PARSE_* in structures.h)
+#define REDFA_OK 0
+#define REDFA_ESYMBOL 1
+#define REDFA_EPARENTHESIS 2
+#define REDFA_EOPERAND 3
+
+// compile flags
+#define REDFA_SEARCH 1  // also build the unanchored searcher (redfaSearch)
+
+typedef struct redfa redfa;
+
+// state of one input fed in fragments (see matchStream)
+typedef struct redfaStream
+{
+    uint32_t state;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t matchEnd;
+} redfaStream;
+
+// NULL on error, with the code in *error (if error is not NULL)
+REDFA_API redfa *redfaCompile(const char *regex, int flags, int *error);
+REDFA_API const char *redfaError(int error);
+REDFA_API void redfaFree(redfa *R);
+
+// 1 if the whole input matches
+REDFA_API int redfaMatch(const redfa *R, const char *input, size_t size);
+
+// results[i] = redfaMatch of inputs[i], the n inputs scanned in lockstep
+REDFA_API void redfaMatchBatch(const redfa *R, const char **inputs, const size_t *sizes, int n, int *results);
+
+// leftmost match among those with the earliest end, from pos: 1 and
+// [start, end) if found, 0 if not, -1 if compiled without REDFA_SEARCH
+REDFA_API int redfaSearch(const redfa *R, const char *input, size_t size, size_t pos, size_t *start, size_t *end);
+
+// full match of input given in fragments
+REDFA_API void redfaStreamInit(const redfa *R, redfaStream *st);
+REDFA_API void redfaStreamFeed(const redfa *R, redfaStream *st, const char *input, size_t size);
+REDFA_API int redfaStreamAccept(const redfa *R, const redfaStream *st);
+
+#endif
@@ -0,0 +1,400 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "reduce.h"
+#include "nfa.h"
+
+//NFA Reduction Functions
+//-----------------------
+//  Rewrites until none applies (s0 stays initial and the last state
+//  stays the only final one; neither is ever removed):
+//    1. s whose only transition is s -e-> t: edges into s go to t
+//    2. s whose only incoming edge is p -e-> s: s's transitions move to p
+//    3. states with the same transitions (and finality) are merged
+//    4. states on a cycle of e edges (same e closure) are merged
+//  then states unreachable from s0 or that cannot reach the final state
+//  are dropped and the rest renumbered in order
+
+typedef struct arc
+{
+    char symbol;
+    int state;
+} arc;
+
+typedef struct arcs
+{
+    int n;
+    int capacity;
+    arc *a;
+} arcs;
+
+typedef struct reducer
+{
+    int nStates;
+    int final;
+    arcs *out;
+    int *to; // state each state was merged into (itself if kept)
+} reducer;
+
+static void addArc(arcs *A, char symbol, int state)
+{
+    if (A->n == A->capacity)
+    {
+        A->capacity = A->capacity ? 2 * A->capacity : 4;
+        A->a = realloc(A->a, A->capacity * sizeof(arc));
+    }
+    A->a[A->n].symbol = symbol;
+    A->a[A->n++].state = state;
+}
+
+static int findState(reducer *R, int s)
+{
+    int r = s;
+    while (R->to[r] != r)
+        r = R->to[r];
+    while (R->to[s] != r)
+    {
+        int next = R->to[s];
+        R->to[s] = r;
+        s = next;
+    }
+    return r;
+}
+
+static int compareArcs(const void *a, const void *b)
+{
+    const arc *x = a, *y = b;
+    if (x->symbol != y->symbol)
+        return x->symbol - y->symbol;
+    return x->state - y->state;
+}
+
+// targets resolved, e self loops dropped, sorted without duplicates
+static void normalizeArcs(reducer *R, int s)
+{
+    arcs *A = R->out + s;
+    int i, n = 0;
+    for (i = 0; i < A->n; i++)
+    {
+        A->a[i].state = findState(R, A->a[i].state);
+        if (A->a[i].symbol != EPSILON || A->a[i].state != s)
+            A->a[n++] = A->a[i];
+    }
+    qsort(A->a, n, sizeof(arc), compareArcs);
+    for (i = A->n = 0; i < n; i++)
+        if (!i || compareArcs(A->a + i, A->a + i - 1))
+            A->a[A->n++] = A->a[i];
+}
+
+static int removable(reducer *R, int s)
+{
+    return s && s != R->final && R->to[s] == s;
+}
+
+// rule 1
+static int contractChains(reducer *R)
+{
+    int s, changed = 0;
+    for (s = 0; s < R->nStates; s++)
+    {
+        arcs *A = R->out + s;
+        if (removable(R, s) && A->n == 1 && A->a[0].symbol == EPSILON && findState(R, A->a[0].state) != s)
+        {
+            R->to[s] = findState(R, A->a[0].state);
+            A->n = 0;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// rule 2
+static int absorbStates(reducer *R)
+{
+    int *in = calloc(R->nStates, sizeof(int)), *from = malloc(R->nStates * sizeof(int));
+    int s, i, changed = 0;
+    for (s = 0; s < R->nStates; s++)
+        for (i = 0; i < R->out[s].n; i++)
+        {
+            arc *a = R->out[s].a + i;
+            in[a->state] += 1 + (a->symbol != EPSILON) * R->nStates; // symbol edges block
+            from[a->state] = s;
+        }
+    for (s = 0; s < R->nStates; s++)
+    {
+        int p = from[s];
+        if (!removable(R, s) || in[s] != 1 || p == s)
+            continue;
+        for (i = 0; i < R->out[p].n && R->out[p].a[i].state != s; i++)
+            ;
+        R->out[p].a[i] = R->out[p].a[--R->out[p].n];
+        for (i = 0; i < R->out[s].n; i++)
+        {
+            arc *a = R->out[s].a + i;
+            addArc(R->out + p, a->symbol, a->state);
+            if (in[a->state] == 1)
+                from[a->state] = p;
+        }
+        R->out[s].n = 0;
+        R->to[s] = p; // unreferenced from now on
+        changed = 1;
+    }
+    free(in);
+    free(from);
+    return changed;
+}
+
+static unsigned hashArcs(reducer *R, int s)
+{
+    unsigned h = (s == R->final) * 2654435761u;
+    int i;
+    for (i = 0; i < R->out[s].n; i++)
+        h = (h ^ (R->out[s].a[i].state * 131u + (unsigned char)R->out[s].a[i].symbol)) * 16777619u;
+    return h;
+}
+
+static int sameArcs(reducer *R, int a, int b)
+{
+    return (a == R->final) == (b == R->final) && R->out[a].n == R->out[b].n &&
+           !memcmp(R->out[a].a, R->out[b].a, R->out[a].n * sizeof(arc));
+}
+
+static int compareKeys(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+    return x < y ? -1 : x > y;
+}
+
+// rule 3: (hash, state) keys sorted put candidates side by side, the
+// lowest state of each class is kept
+static int mergeStates(reducer *R)
+{
+    unsigned long *keys = malloc(R->nStates * sizeof(unsigned long));
+    int s, i, j, n = 0, changed = 0;
+    for (s = 0; s < R->nStates; s++)
+        if (R->to[s] == s)
+            keys[n++] = (unsigned long)hashArcs(R, s) << 32 | (unsigned)s;
+    qsort(keys, n, sizeof(unsigned long), compareKeys);
+    for (i = 0; i < n; i++)
+    {
+        int a = keys[i] & 0xFFFFFFFFu;
+        if (R->to[a] != a)
+            continue;
+        for (j = i + 1; j < n && keys[j] >> 32 == keys[i] >> 32; j++)
+        {
+            int b = keys[j] & 0xFFFFFFFFu;
+            if (R->to[b] == b && removable(R, b) && sameArcs(R, a, b))
+            {
+                R->to[b] = a;
+                R->out[b].n = 0;
+                changed = 1;
+            }
+        }
+    }
+    free(keys);
+    return changed;
+}
+
+// rule 4: Tarjan over the e edges, iterative; a component keeps s0,
+// else the final state, else its lowest state
+static int mergeCycles(reducer *R)
+{
+    int n = R->nStates, counter = 0, top = 0, depth = 0, changed = 0, s, i;
+    int *index = malloc(n * sizeof(int)), *low = malloc(n * sizeof(int));
+    int *stack = malloc(n * sizeof(int)), *path = malloc(n * sizeof(int)), *next = malloc(n * sizeof(int));
+    char *onStack = calloc(n, sizeof(char));
+    for (s = 0; s < n; s++)
+        index[s] = -1;
+    for (s = 0; s < n; s++)
+    {
+        if (index[s] >= 0 || R->to[s] != s)
+            continue;
+        path[depth++] = s;
+        index[s] = low[s] = counter++;
+        next[s] = 0;
+        stack[top++] = s;
+        onStack[s] = 1;
+        while (depth)
+        {
+            int v = path[depth - 1];
+            arcs *A = R->out + v;
+            if (next[v] < A->n)
+            {
+                arc *a = A->a + next[v]++;
+                int w = a->state;
+                if (a->symbol != EPSILON)
+                    continue;
+                if (index[w] < 0)
+                {
+                    path[depth++] = w;
+                    index[w] = low[w] = counter++;
+                    next[w] = 0;
+                    stack[top++] = w;
+                    onStack[w] = 1;
+                }
+                else if (onStack[w] && index[w] < low[v])
+                    low[v] = index[w];
+                continue;
+            }
+            depth--;
+            if (depth && low[v] < low[path[depth - 1]])
+                low[path[depth - 1]] = low[v];
+            if (low[v] == index[v])
+            {
+                // component = stack above v
+                int first = top, rep = -1, keep = 0;
+                do
+                    onStack[stack[--first]] = 0;
+                while (stack[first] != v);
+                for (i = first; i < top; i++)
+                {
+                    int w = stack[i];
+                    keep += !removable(R, w);
+                    if (rep < 0 || (!removable(R, w) && removable(R, rep)) ||
+                        (removable(R, w) == removable(R, rep) && w < rep))
+                        rep = w;
+                }
+                for (i = first; i < top && top - first > 1 && keep < 2; i++)
+                {
+                    int j, w = stack[i];
+                    if (w == rep)
+                        continue;
+                    for (j = 0; j < R->out[w].n; j++)
+                        addArc(R->out + rep, R->out[w].a[j].symbol, R->out[w].a[j].state);
+                    R->out[w].n = 0;
+                    R->to[w] = rep;
+                    changed = 1;
+                }
+                top = first;
+            }
+        }
+    }
+    free(index);
+    free(low);
+    free(stack);
+    free(path);
+    free(next);
+    free(onStack);
+    return changed;
+}
+
+// marks the states reached from s over the arcs (or reversed arcs)
+static void markReached(reducer *R, int s, int backwards, char *mark)
+{
+    int *stack = malloc(R->nStates * sizeof(int)), top = 0, i, t;
+    int *first = NULL, *from = NULL;
+    if (backwards)
+    {
+        // reversed arcs in CSR form
+        first = calloc(R->nStates + 1, sizeof(int));
+        for (t = 0; t < R->nStates; t++)
+            for (i = 0; i < R->out[t].n; i++)
+                first[R->out[t].a[i].state + 1]++;
+        for (t = 0; t < R->nStates; t++)
+            first[t + 1] += first[t];
+        from = malloc((first[R->nStates] + 1) * sizeof(int));
+        for (t = 0; t < R->nStates; t++)
+            for (i = 0; i < R->out[t].n; i++)
+                from[first[R->out[t].a[i].state]++] = t;
+        for (t = R->nStates; t > 0; t--)
+            first[t] = first[t - 1];
+        first[0] = 0;
+    }
+    mark[s] = 1;
+    stack[top++] = s;
+    while (top)
+    {
+        s = stack[--top];
+        if (backwards)
+            for (i = first[s]; i < first[s + 1]; i++)
+            {
+                if (!mark[from[i]])
+                {
+                    mark[from[i]] = 1;
+                    stack[top++] = from[i];
+                }
+            }
+        else
+            for (i = 0; i < R->out[s].n; i++)
+            {
+                t = R->out[s].a[i].state;
+                if (!mark[t])
+                {
+                    mark[t] = 1;
+                    stack[top++] = t;
+                }
+            }
+    }
+    free(stack);
+    free(first);
+    free(from);
+}
+
+nfa *reduceNfa(nfa *N)
+{
+    reducer R;
+    nfa *M = malloc(sizeof(nfa));
+    char *reached, *live;
+    int *id, s, i, changed = 1;
+    R.nStates = N->nStates;
+    R.final = N->nStates - 1;
+    R.out = calloc(R.nStates, sizeof(arcs));
+    R.to = malloc(R.nStates * sizeof(int));
+    for (s = 0; s < R.nStates; s++)
+    {
+        link *L;
+        R.to[s] = s;
+        for (L = N->transitions[s]; L; L = L->next)
+            addArc(R.out + s, L->symbol, L->state);
+    }
+    while (changed)
+    {
+        for (s = 0; s < R.nStates; s++)
+            normalizeArcs(&R, s);
+        changed = contractChains(&R) || absorbStates(&R) || mergeStates(&R) || mergeCycles(&R);
+    }
+    // useless states: unreached from s0 or not reaching the final state
+    reached = calloc(R.nStates, sizeof(char));
+    live = calloc(R.nStates, sizeof(char));
+    markReached(&R, 0, 0, reached);
+    markReached(&R, R.final, 1, live);
+    id = malloc(R.nStates * sizeof(int));
+    for (s = M->nStates = 0; s < R.nStates; s++)
+        id[s] = !s || s == R.final || (reached[s] && live[s]) ? M->nStates++ : -1;
+    M->transitions = malloc(M->nStates * sizeof(link *));
+    for (s = 0; s < R.nStates; s++)
+    {
+        if (id[s] < 0)
+            continue;
+        M->transitions[id[s]] = NULL;
+        for (i = R.out[s].n - 1; i >= 0; i--)
+            if (id[R.out[s].a[i].state] >= 0)
+                insertLink(M->transitions + id[s], R.out[s].a[i].symbol, id[R.out[s].a[i].state]);
+    }
+    for (s = 0; s < R.nStates; s++)
+        free(R.out[s].a);
+    free(R.out);
+    free(R.to);
+    free(reached);
+    free(live);
+    free(id);
+    return M;
+}
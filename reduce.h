@@ -0,0 +1,9 @@
+#ifndef __REDUCE__
+#define __REDUCE__
+#include "structures.h"
+
+//NFA Reduction Functions
+//-----------------------
+nfa *reduceNfa(nfa *);
+
+#endif
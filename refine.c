@@ -0,0 +1,286 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "refine.h"
+#include "dfa.h"
+
+//Parallel Minimization Functions
+//-------------------------------
+//  The only minimizer (minimize and minimizePartition run it on the
+//  calling thread). The partition is refined in rounds: in a round the
+//  states of group k with equal rows of successor groups form a class;
+//  the class of the first state keeps k and the others get new numbers
+//  in order of (k, first state), so the dfa does not depend on the
+//  number of threads. Each round:
+//    1. rows and signature hashes (threads by slices of states), and
+//       states bucketed by owner thread = hash % nThreads
+//    2. representative (first state) of each class, in hash tables
+//       (threads by owned bucket, states visited in order)
+//    3. representatives that open new groups (by slices)
+//    4. new group numbers (one thread, sorts only the new groups)
+//    5. group of each state = group of its representative (by slices)
+
+typedef struct refiner
+{
+    dfa *D;
+    int nThreads;
+    int nGroups;
+    int stop;
+    int *groups;    // group of each state
+    int *rows;      // groups of the successors of each state
+    unsigned *hash; // hash of the group and row of each state
+    int *counts;    // counts[slice * nThreads + owner]
+    int *owned;     // states by owner, in order within each owner
+    int *rep;       // first state with the same group and row
+    int *label;     // group of each representative after the round
+    int *first;     // first state of each group
+    int **opens;    // per thread: representatives that open new groups
+    int *nOpens;
+    pthread_barrier_t barrier;
+} refiner;
+
+typedef struct refineThread
+{
+    refiner *R;
+    int id;
+} refineThread;
+
+static int sameSignature(refiner *R, int a, int b)
+{
+    int n = R->D->nSymbols;
+    return R->hash[a] == R->hash[b] && R->groups[a] == R->groups[b] &&
+           !memcmp(R->rows + (size_t)a * n, R->rows + (size_t)b * n, n * sizeof(int));
+}
+
+static int compareKeys(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a, y = *(const unsigned long *)b;
+    return x < y ? -1 : x > y;
+}
+
+// step 4: (group, state) keys sorted give the sequential numbering
+static void numberGroups(refiner *R)
+{
+    unsigned long *keys;
+    int i, j, n = 0;
+    for (i = 0; i < R->nThreads; i++)
+        n += R->nOpens[i];
+    keys = malloc((n ? n : 1) * sizeof(unsigned long));
+    for (i = 0, n = 0; i < R->nThreads; i++)
+        for (j = 0; j < R->nOpens[i]; j++, n++)
+            keys[n] = (unsigned long)R->groups[R->opens[i][j]] << 32 | (unsigned)R->opens[i][j];
+    qsort(keys, n, sizeof(unsigned long), compareKeys);
+    for (i = 0; i < n; i++)
+    {
+        int s = keys[i] & 0xFFFFFFFFu;
+        R->label[s] = R->nGroups;
+        R->first[R->nGroups++] = s;
+    }
+    R->stop = !n || R->nGroups >= R->D->nStates;
+    free(keys);
+}
+
+static void *refineWorker(void *arg)
+{
+    refineThread *W = arg;
+    refiner *R = W->R;
+    dfa *D = R->D;
+    int n = D->nStates, m = D->nSymbols, T = R->nThreads, id = W->id;
+    int lo = (long)n * id / T, hi = (long)n * (id + 1) / T;
+    int *table = NULL, capacity = 0, opensCapacity = 0;
+    int *offset = malloc(T * sizeof(int));
+    int i, j, start;
+    while (!R->stop)
+    {
+        // 1. rows and hashes of the slice, then buckets by owner
+        memset(R->counts + id * T, 0, T * sizeof(int));
+        for (i = lo; i < hi; i++)
+        {
+            unsigned h = R->groups[i] * 2654435761u;
+            for (j = 0; j < m; j++)
+            {
+                int g = R->groups[D->transitions[(size_t)i * m + j]];
+                R->rows[(size_t)i * m + j] = g;
+                h = (h ^ g) * 16777619u;
+            }
+            R->hash[i] = h ^ h >> 15;
+            R->counts[id * T + R->hash[i] % T]++;
+        }
+        pthread_barrier_wait(&R->barrier);
+        for (j = 0, start = 0; j < T; j++)
+        {
+            int k;
+            offset[j] = start;
+            for (k = 0; k < T; k++)
+                offset[j] += k < id ? R->counts[k * T + j] : 0;
+            for (k = 0; k < T; k++)
+                start += R->counts[k * T + j];
+        }
+        for (i = lo; i < hi; i++)
+            R->owned[offset[R->hash[i] % T]++] = i;
+        pthread_barrier_wait(&R->barrier);
+        // 2. classes of the states this thread owns
+        {
+            int owned = 0, mask, k;
+            for (j = 0, start = 0; j < T; j++)
+                for (k = 0; k < T; k++)
+                    if (j < id)
+                        start += R->counts[k * T + j];
+                    else if (j == id)
+                        owned += R->counts[k * T + j];
+            if (2 * owned > capacity)
+            {
+                for (capacity = capacity ? capacity : 64; capacity < 2 * owned;)
+                    capacity *= 2;
+                table = realloc(table, capacity * sizeof(int));
+            }
+            memset(table, -1, capacity * sizeof(int));
+            mask = capacity - 1;
+            for (k = start; k < start + owned; k++)
+            {
+                int slot;
+                i = R->owned[k];
+                slot = R->hash[i] / T & mask;
+                while (table[slot] >= 0 && !sameSignature(R, table[slot], i))
+                    slot = (slot + 1) & mask;
+                if (table[slot] < 0)
+                    table[slot] = i;
+                R->rep[i] = table[slot];
+            }
+        }
+        pthread_barrier_wait(&R->barrier);
+        // 3. representatives of the slice that open new groups
+        R->nOpens[id] = 0;
+        for (i = lo; i < hi; i++)
+        {
+            if (R->rep[i] != i)
+                continue;
+            R->label[i] = R->groups[i];
+            if (R->first[R->groups[i]] == i)
+                continue;
+            if (R->nOpens[id] == opensCapacity)
+            {
+                opensCapacity = opensCapacity ? 2 * opensCapacity : 64;
+                R->opens[id] = realloc(R->opens[id], opensCapacity * sizeof(int));
+            }
+            R->opens[id][R->nOpens[id]++] = i;
+        }
+        pthread_barrier_wait(&R->barrier);
+        // 4. numbering
+        if (!id)
+            numberGroups(R);
+        pthread_barrier_wait(&R->barrier);
+        // 5. new groups of the slice
+        for (i = lo; i < hi; i++)
+            R->groups[i] = R->label[R->rep[i]];
+        pthread_barrier_wait(&R->barrier);
+    }
+    free(table);
+    free(offset);
+    return NULL;
+}
+
+// minimizePartition with nThreads threads (1 = no thread is created)
+dfa *minimizePartitionParallel(dfa *D, int *partition, int nThreads)
+{
+    refiner R;
+    refineThread *W;
+    pthread_t *threads;
+    dfa *Dmin;
+    int i, n = D->nStates, oneGroup = 1;
+    if (nThreads < 1)
+        nThreads = 1;
+    R.D = D;
+    R.nThreads = nThreads;
+    R.nGroups = 0;
+    R.groups = malloc(n * sizeof(int));
+    R.first = malloc(n * sizeof(int));
+    for (i = 0; i < n; i++)
+    {
+        R.groups[i] = partition[i];
+        if (partition[i] != partition[0])
+            oneGroup = 0;
+        if (partition[i] >= R.nGroups)
+            R.nGroups = partition[i] + 1;
+    }
+    if (oneGroup) // nothing to refine: one state
+    {
+        memset(R.groups, 0, n * sizeof(int));
+        Dmin = groupDfa(D, R.groups, 1);
+        free(R.groups);
+        free(R.first);
+        return Dmin;
+    }
+    for (i = n - 1; i >= 0; i--)
+        R.first[partition[i]] = i;
+    R.stop = R.nGroups >= n;
+    R.rows = malloc((size_t)n * D->nSymbols * sizeof(int));
+    R.hash = malloc(n * sizeof(unsigned));
+    R.counts = malloc((size_t)nThreads * nThreads * sizeof(int));
+    R.owned = malloc(n * sizeof(int));
+    R.rep = malloc(n * sizeof(int));
+    R.label = malloc(n * sizeof(int));
+    R.opens = calloc(nThreads, sizeof(int *));
+    R.nOpens = calloc(nThreads, sizeof(int));
+    pthread_barrier_init(&R.barrier, NULL, nThreads);
+    W = malloc(nThreads * sizeof(refineThread));
+    threads = malloc(nThreads * sizeof(pthread_t));
+    for (i = 0; i < nThreads; i++)
+    {
+        W[i].R = &R;
+        W[i].id = i;
+        if (i)
+            pthread_create(threads + i, NULL, refineWorker, W + i);
+    }
+    refineWorker(W);
+    for (i = 1; i < nThreads; i++)
+        pthread_join(threads[i], NULL);
+    pthread_barrier_destroy(&R.barrier);
+    Dmin = groupDfa(D, R.groups, R.nGroups);
+    for (i = 0; i < nThreads; i++)
+        free(R.opens[i]);
+    free(R.opens);
+    free(R.nOpens);
+    free(R.groups);
+    free(R.first);
+    free(R.rows);
+    free(R.hash);
+    free(R.counts);
+    free(R.owned);
+    free(R.rep);
+    free(R.label);
+    free(W);
+    free(threads);
+    return Dmin;
+}
+
+dfa *minimizeParallel(dfa *D, int nThreads)
+{
+    int *partition = malloc(D->nStates * sizeof(int));
+    dfaState *st;
+    dfa *Dmin;
+    int i;
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        partition[i] = st->final;
+    Dmin = minimizePartitionParallel(D, partition, nThreads);
+    free(partition);
+    return Dmin;
+}
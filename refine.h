@@ -0,0 +1,10 @@
+#ifndef __REFINE__
+#define __REFINE__
+#include "structures.h"
+
+//Parallel Minimization Functions
+//-------------------------------
+dfa *minimizeParallel(dfa *, int);
+dfa *minimizePartitionParallel(dfa *, int *, int);
+
+#endif
@@ -0,0 +1,376 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "search.h"
+#include "nfa.h"
+#include "dfa.h"
+#include "table.h"
+
+//Unanchored Search Functions
+//---------------------------
+
+// Forward dfa of the search, on the threads (live states) of D started
+// at each position:
+//  searching -> a new thread starts on every symbol, the first final
+//               thread ends the search (the earliest match end)
+//  matched   -> no new thread, final while a thread is final, and dead
+//               when no thread is left: the match cannot grow any more
+// A state is (matched, sorted threads), found in a hash table
+typedef struct threadSets
+{
+    int n;
+    int capacity;
+    int *start; // threads of state i: pool[start[i]..start[i]+length[i]-1]
+    int *length;
+    char *matched;
+    int *pool;
+    size_t nPool;
+    size_t poolCapacity;
+    int tableSize;
+    int *table;
+} threadSets;
+
+static unsigned hashThreads(const int *t, int n, int matched)
+{
+    unsigned h = 2166136261u ^ matched;
+    int i;
+    for (i = 0; i < n; i++)
+        h = (h ^ t[i]) * 16777619u;
+    return h;
+}
+
+static int *findThreads(threadSets *S, const int *t, int n, int matched)
+{
+    int mask = S->tableSize - 1, h = hashThreads(t, n, matched) & mask, k;
+    while ((k = S->table[h]) >= 0 &&
+           (S->matched[k] != matched || S->length[k] != n || memcmp(S->pool + S->start[k], t, n * sizeof(int))))
+        h = (h + 1) & mask;
+    return S->table + h;
+}
+
+// state of the threads t[0..n-1], added if new
+static int threadState(threadSets *S, const int *t, int n, int matched)
+{
+    int *slot = findThreads(S, t, n, matched), i;
+    if (*slot >= 0)
+        return *slot;
+    if (S->n == S->capacity)
+    {
+        S->capacity *= 2;
+        S->start = realloc(S->start, S->capacity * sizeof(int));
+        S->length = realloc(S->length, S->capacity * sizeof(int));
+        S->matched = realloc(S->matched, S->capacity);
+    }
+    while (S->nPool + n > S->poolCapacity)
+    {
+        S->poolCapacity *= 2;
+        S->pool = realloc(S->pool, S->poolCapacity * sizeof(int));
+    }
+    memcpy(S->pool + S->nPool, t, n * sizeof(int));
+    S->start[S->n] = S->nPool;
+    S->length[S->n] = n;
+    S->matched[S->n] = matched;
+    S->nPool += n;
+    *slot = S->n++;
+    if (2 * S->n > S->tableSize)
+    {
+        S->tableSize *= 2;
+        S->table = realloc(S->table, S->tableSize * sizeof(int));
+        memset(S->table, -1, S->tableSize * sizeof(int));
+        for (i = 0; i < S->n; i++)
+            *findThreads(S, S->pool + S->start[i], S->length[i], S->matched[i]) = i;
+    }
+    return S->n - 1;
+}
+
+static int compareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return x < y ? -1 : x > y;
+}
+
+// *matched[i] = 1 if state i of the result is in the matched part
+static dfa *forwardDfa(dfa *D, char **matched)
+{
+    threadSets S;
+    dfa *F = malloc(sizeof(dfa));
+    dfaState *st, *tail = NULL;
+    int n = D->nStates, m = D->nSymbols, init = initialState(D), dead = deadState(D);
+    char *final = malloc(n);
+    int *next = malloc((n + 1) * sizeof(int)), *mark = calloc(n, sizeof(int));
+    int *transitions, capacity = 64, k, c, j, stamp = 0;
+    for (k = 0, st = D->states; st; k++, st = st->next)
+        final[k] = st->final;
+    S.n = 0;
+    S.capacity = 64;
+    S.start = malloc(S.capacity * sizeof(int));
+    S.length = malloc(S.capacity * sizeof(int));
+    S.matched = malloc(S.capacity);
+    S.nPool = 0;
+    S.poolCapacity = 256;
+    S.pool = malloc(S.poolCapacity * sizeof(int));
+    S.tableSize = 128;
+    S.table = malloc(S.tableSize * sizeof(int));
+    memset(S.table, -1, S.tableSize * sizeof(int));
+    transitions = malloc((size_t)capacity * m * sizeof(int));
+    threadState(&S, NULL, 0, 0); // searching, no thread yet
+    for (k = 0; k < S.n; k++)
+    {
+        if (k == capacity)
+        {
+            capacity *= 2;
+            transitions = realloc(transitions, (size_t)capacity * m * sizeof(int));
+        }
+        for (c = 0; c < m; c++)
+        {
+            int nt = 0, isFinal = 0, t;
+            stamp++;
+            for (j = 0; j <= S.length[k]; j++)
+            {
+                if (j < S.length[k])
+                    t = D->transitions[S.pool[S.start[k] + j] * m + c];
+                else if (!S.matched[k])
+                    t = D->transitions[init * m + c];
+                else
+                    break;
+                if (t == dead || mark[t] == stamp)
+                    continue;
+                mark[t] = stamp;
+                next[nt++] = t;
+                isFinal |= final[t];
+            }
+            qsort(next, nt, sizeof(int), compareInts);
+            transitions[k * m + c] = threadState(&S, next, nt, S.matched[k] || isFinal);
+        }
+    }
+    F->nStates = S.n;
+    F->nSymbols = m;
+    F->sigma = malloc(m + 1);
+    memcpy(F->sigma, D->sigma, m + 1);
+    F->transitions = transitions;
+    F->states = NULL;
+    for (k = 0; k < S.n; k++)
+    {
+        st = malloc(sizeof(dfaState));
+        st->final = 0;
+        for (j = 0; S.matched[k] && j < S.length[k] && !st->final; j++)
+            st->final = final[S.pool[S.start[k] + j]];
+        st->initial = !k;
+        st->kind = STATE_LIVE;
+        st->stateSet = NULL;
+        st->next = NULL;
+        if (tail)
+            tail->next = st;
+        else
+            F->states = st;
+        tail = st;
+    }
+    *matched = S.matched;
+    free(S.start);
+    free(S.length);
+    free(S.pool);
+    free(S.table);
+    free(final);
+    free(next);
+    free(mark);
+    return F;
+}
+
+// dfa with reversed transitions: s0 -e-> final states, initial -e-> s(n+1)
+static nfa *reverseNfa(dfa *D)
+{
+    nfa *N = malloc(sizeof(nfa));
+    int n = D->nStates, init = initialState(D), dead = deadState(D);
+    dfaState *st;
+    int i, j, t;
+    N->nStates = n + 2;
+    N->transitions = malloc(N->nStates * sizeof(link *));
+    for (i = 0; i < N->nStates; i++)
+        N->transitions[i] = NULL;
+    for (i = 0, st = D->states; st; i++, st = st->next)
+    {
+        if (st->final)
+            insertLink(N->transitions + 0, EPSILON, i + 1);
+        for (j = 0; j < D->nSymbols && i != dead; j++)
+        {
+            t = D->transitions[i * D->nSymbols + j];
+            if (t != dead)
+                insertLink(N->transitions + t + 1, D->sigma[j], i + 1);
+        }
+    }
+    insertLink(N->transitions + init + 1, EPSILON, n + 1);
+    return N;
+}
+
+static compactTable *nfaToTable(nfa *N, int width)
+{
+    dfa *A = nfaToDfa(N);
+    dfa *Amin = minimize(A);
+    compactTable *T = buildCompactTableWidth(Amin, width);
+    disposeNfaAutomata(N);
+    disposeDfaAutomata(A);
+    disposeDfaAutomata(Amin);
+    return T;
+}
+
+// minimized forward dfa: searching, final and other matched states start
+// in different groups. Bytes outside sigma restart a search and end a
+// match (the dead state)
+static compactTable *forwardTable(dfa *D, int width)
+{
+    char *matched;
+    dfa *F = forwardDfa(D, &matched), *Fmin;
+    int *partition = malloc(F->nStates * sizeof(int)), label[3] = {-1, -1, -1}, nLabels = 0, i;
+    compactTable *T;
+    dfaState *st;
+    for (i = 0, st = F->states; st; i++, st = st->next)
+    {
+        int g = !matched[i] ? 0 : st->final ? 1 : 2;
+        if (label[g] < 0)
+            label[g] = nLabels++;
+        partition[i] = label[g];
+    }
+    Fmin = minimizePartition(F, partition);
+    T = buildCompactTableWidth(Fmin, width);
+    for (i = 0, st = Fmin->states; st; i++, st = st->next)
+        if (!matched[st->stateSet->info])
+            setCompactTable(T, i, 0, T->initial);
+    accelerateCompactTable(T);
+    disposeDfaAutomata(F);
+    disposeDfaAutomata(Fmin);
+    free(matched);
+    free(partition);
+    return T;
+}
+
+searcher *buildSearcher(dfa *D)
+{
+    searcher *S = malloc(sizeof(searcher));
+    S->F = forwardTable(D, 1);
+    S->R = nfaToTable(reverseNfa(D), S->F->width);
+    if (S->R->width > S->F->width)
+    {
+        disposeCompactTable(S->F);
+        S->F = forwardTable(D, S->R->width);
+    }
+    // one row layout for both scans
+    if ((S->F->shift < 0) != (S->R->shift < 0))
+        unpadCompactTable(S->F->shift < 0 ? S->R : S->F);
+    return S;
+}
+
+// Forward scan to the earliest match end, on to the longest one (the
+// last final state before the dead state), then backward scan (bounded
+// by pos) to the leftmost start of a match ending there
+#define SEARCH_LOOP(name, type, op, row)                                                 \
+    static int name(searcher *S, const unsigned char *p, size_t size, size_t pos,        \
+                    size_t *start, size_t *end)                                          \
+    {                                                                                    \
+        const type *f = S->F->data, *r = S->R->data;                                     \
+        const unsigned char *fc = S->F->classes, *rc = S->R->classes;                    \
+        const unsigned char *fa = S->F->accept, *ra = S->R->accept;                      \
+        uint32_t fk = S->F->row, rk = S->R->row;                                         \
+        accelState *a = S->F->nAccel ? S->F->accel : NULL;                               \
+        uint32_t s = S->F->initial, fdead = S->F->dead, rdead = S->R->dead;              \
+        uint32_t next, run = 0;                                                          \
+        size_t i;                                                                        \
+        if (!a)                                                                          \
+            for (i = pos; i < size && !fa[s = f[(s op fk) + fc[p[i]]]]; i++)             \
+                ;                                                                        \
+        else                                                                             \
+            for (i = pos; i < size; i++)                                                 \
+            {                                                                            \
+                next = f[(s op fk) + fc[p[i]]];                                          \
+                run = (run + 1) & -(uint32_t)(next == s);                                \
+                if (run >= ACCEL_RUN && a[s].kind)                                       \
+                {                                                                        \
+                    i = (const unsigned char *)skipAccelState(a + s, fc,                 \
+                            (const char *)p + i + 1, (const char *)p + size) - p - 1;    \
+                    run = 0;                                                             \
+                }                                                                        \
+                s = next;                                                                \
+                if (fa[s])                                                               \
+                    break;                                                               \
+            }                                                                            \
+        if (i == size)                                                                   \
+            return 0;                                                                    \
+        for (*end = ++i; i < size && (s = f[(s op fk) + fc[p[i]]]) != fdead; i++)        \
+            if (fa[s])                                                                   \
+                *end = i + 1;                                                            \
+        *start = i = *end;                                                               \
+        for (s = S->R->initial; i-- > pos;)                                              \
+        {                                                                                \
+            s = r[(s op rk) + rc[p[i]]];                                                 \
+            if (ra[s])                                                                   \
+                *start = i;                                                              \
+            else if (s == rdead)                                                         \
+                break;                                                                   \
+        }                                                                                \
+        return 1;                                                                        \
+    }
+
+SEARCH_LOOP(search8, uint8_t, <<, shift)
+SEARCH_LOOP(search16, uint16_t, <<, shift)
+SEARCH_LOOP(search32, uint32_t, <<, shift)
+SEARCH_LOOP(searchExact16, uint16_t, *, stride)
+SEARCH_LOOP(searchExact32, uint32_t, *, stride)
+
+int nextMatch(searcher *S, const char *buffer, size_t size, size_t pos, size_t *start, size_t *end)
+{
+    const unsigned char *p = (const unsigned char *)buffer;
+    if (S->F->shift < 0)
+        return S->F->width == 2 ? searchExact16(S, p, size, pos, start, end)
+                                : searchExact32(S, p, size, pos, start, end);
+    switch (S->F->width)
+    {
+    case 1:
+        return search8(S, p, size, pos, start, end);
+    case 2:
+        return search16(S, p, size, pos, start, end);
+    default:
+        return search32(S, p, size, pos, start, end);
+    }
+}
+
+long searchBuffer(searcher *S, const char *buffer, size_t size, void (*emit)(token *, void *), void *user)
+{
+    size_t pos = 0, start, end;
+    long count = 0;
+    token tk;
+    tk.rule = 0;
+    while (nextMatch(S, buffer, size, pos, &start, &end))
+    {
+        tk.offset = start;
+        tk.length = end - start;
+        emit(&tk, user);
+        pos = end;
+        count++;
+    }
+    return count;
+}
+
+void disposeSearcher(searcher *S)
+{
+    if (!S) return;
+    disposeCompactTable(S->F);
+    disposeCompactTable(S->R);
+    free(S);
+}
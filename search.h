@@ -0,0 +1,12 @@
+#ifndef __SEARCH__
+#define __SEARCH__
+#include "structures.h"
+
+//Unanchored Search Functions
+//---------------------------
+searcher *buildSearcher(dfa *);
+int nextMatch(searcher *, const char *, size_t, size_t, size_t *, size_t *);
+long searchBuffer(searcher *, const char *, size_t, void (*)(token *, void *), void *);
+void disposeSearcher(searcher *);
+
+#endif
@@ -0,0 +1,617 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "redfa.h"
+
+//Server Functions
+//----------------
+//  One thread runs the epoll loop: it accepts connections, cuts frames
+//  and writes replies. Compile requests and batches of match requests
+//  (grouped by automaton) go to a pool of worker threads; a worker hands
+//  finished requests back through a done list and wakes the loop with a
+//  byte on a socket pair. Connections are only touched by the loop.
+
+typedef struct buffer
+{
+    char *data;
+    size_t n;
+    size_t capacity;
+} buffer;
+
+typedef struct connection connection;
+
+typedef struct request
+{
+    connection *conn;
+    char op;
+    redfa *R;
+    char *data;
+    size_t size;
+    buffer reply;
+    int done;
+    struct request *next; // next reply due on the connection
+} request;
+
+struct connection
+{
+    int fd;
+    int closed;
+    int writing;
+    buffer in;
+    buffer out;
+    request *head; // replies in request order
+    request *tail;
+};
+
+typedef struct task
+{
+    int n;
+    request **reqs;
+    struct task *next;
+} task;
+
+typedef struct server
+{
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    task *todo;
+    task *todoTail;
+    task *done;
+    int stop;
+    int wake[2];
+    // compiled automata: id = index, looked up by regex in a hash
+    // table of ids (-1 = free slot). errors[id] is -1 while a worker
+    // compiles it (the others wait on compiled), then the compile error
+    int nRegexes;
+    int capacity;
+    char **regexes;
+    redfa **automata;
+    int *errors;
+    int tableSize;
+    int *table;
+    pthread_cond_t compiled;
+} server;
+
+static void reserve(buffer *b, size_t n)
+{
+    if (b->n + n <= b->capacity)
+        return;
+    b->capacity = b->capacity ? b->capacity : 256;
+    while (b->n + n > b->capacity)
+        b->capacity *= 2;
+    b->data = realloc(b->data, b->capacity);
+}
+
+static void append(buffer *b, const void *data, size_t n)
+{
+    reserve(b, n);
+    memcpy(b->data + b->n, data, n);
+    b->n += n;
+}
+
+static void appendU32(buffer *b, uint32_t v)
+{
+    append(b, &v, sizeof(v));
+}
+
+// reply = [length][op] + payload written later (length fixed by finish)
+static void startReply(buffer *b, char op)
+{
+    b->n = 0;
+    appendU32(b, 0);
+    append(b, &op, 1);
+}
+
+static void finishReply(buffer *b)
+{
+    uint32_t n = b->n - sizeof(uint32_t);
+    memcpy(b->data, &n, sizeof(n));
+}
+
+static void errorReply(buffer *b, const char *message)
+{
+    startReply(b, 'E');
+    append(b, message, strlen(message));
+    finishReply(b);
+}
+
+//Worker side
+//-----------
+
+// FNV-1a
+static size_t hashRegex(const char *regex)
+{
+    size_t h = 2166136261u;
+    for (; *regex; regex++)
+        h = (h ^ (unsigned char)*regex) * 16777619u;
+    return h;
+}
+
+// slot of the regex in the hash table: its id, or the free slot where
+// it goes (S->lock held)
+static int *findRegex(server *S, const char *regex)
+{
+    size_t mask = S->tableSize - 1, h = hashRegex(regex) & mask;
+    while (S->table[h] >= 0 && strcmp(S->regexes[S->table[h]], regex))
+        h = (h + 1) & mask;
+    return S->table + h;
+}
+
+// new id, compiling (S->lock held)
+static int addRegex(server *S, char *regex)
+{
+    int i, id = S->nRegexes++;
+    if (id == S->capacity)
+    {
+        S->capacity = S->capacity ? 2 * S->capacity : 16;
+        S->regexes = realloc(S->regexes, S->capacity * sizeof(char *));
+        S->automata = realloc(S->automata, S->capacity * sizeof(redfa *));
+        S->errors = realloc(S->errors, S->capacity * sizeof(int));
+    }
+    S->regexes[id] = regex;
+    S->automata[id] = NULL;
+    S->errors[id] = -1;
+    if (2 * S->nRegexes > S->tableSize)
+    {
+        S->tableSize *= 2;
+        S->table = realloc(S->table, S->tableSize * sizeof(int));
+        memset(S->table, -1, S->tableSize * sizeof(int));
+        for (i = 0; i < id; i++)
+            *findRegex(S, S->regexes[i]) = i;
+    }
+    *findRegex(S, regex) = id;
+    return id;
+}
+
+// A regex is compiled once: requests for it while a worker compiles it
+// wait for that worker, so equal regexes always get the same id
+static void compileRequest(server *S, request *q)
+{
+    int id, error;
+    char *regex = malloc(q->size + 1);
+    redfa *R;
+    memcpy(regex, q->data, q->size);
+    regex[q->size] = 0;
+    pthread_mutex_lock(&S->lock);
+    if ((id = *findRegex(S, regex)) >= 0)
+    {
+        free(regex);
+        while (S->errors[id] < 0)
+            pthread_cond_wait(&S->compiled, &S->lock);
+    }
+    else
+    {
+        id = addRegex(S, regex);
+        pthread_mutex_unlock(&S->lock);
+        R = redfaCompile(regex, REDFA_SEARCH, &error);
+        pthread_mutex_lock(&S->lock);
+        S->automata[id] = R;
+        S->errors[id] = R ? REDFA_OK : error;
+        pthread_cond_broadcast(&S->compiled);
+    }
+    error = S->errors[id];
+    pthread_mutex_unlock(&S->lock);
+    if (error)
+    {
+        errorReply(&q->reply, redfaError(error));
+        return;
+    }
+    startReply(&q->reply, 'C');
+    appendU32(&q->reply, id);
+    finishReply(&q->reply);
+}
+
+static void searchRequest(request *q)
+{
+    size_t pos = 0, start, end, count;
+    startReply(&q->reply, 'S');
+    appendU32(&q->reply, 0);
+    for (count = 0; redfaSearch(q->R, q->data, q->size, pos, &start, &end) > 0; count++)
+    {
+        appendU32(&q->reply, start);
+        appendU32(&q->reply, end - start);
+        pos = end;
+    }
+    memcpy(q->reply.data + sizeof(uint32_t) + 1, &(uint32_t){count}, sizeof(uint32_t));
+    finishReply(&q->reply);
+}
+
+// match requests of a task share the automaton: scanned in lockstep
+static void matchRequests(task *t)
+{
+    const char **inputs = malloc(t->n * sizeof(char *));
+    size_t *sizes = malloc(t->n * sizeof(size_t));
+    int *results = malloc(t->n * sizeof(int)), i;
+    for (i = 0; i < t->n; i++)
+    {
+        inputs[i] = t->reqs[i]->data;
+        sizes[i] = t->reqs[i]->size;
+    }
+    redfaMatchBatch(t->reqs[0]->R, inputs, sizes, t->n, results);
+    for (i = 0; i < t->n; i++)
+    {
+        char result = results[i];
+        startReply(&t->reqs[i]->reply, 'M');
+        append(&t->reqs[i]->reply, &result, 1);
+        finishReply(&t->reqs[i]->reply);
+    }
+    free(inputs);
+    free(sizes);
+    free(results);
+}
+
+static void *worker(void *arg)
+{
+    server *S = arg;
+    for (;;)
+    {
+        task *t;
+        pthread_mutex_lock(&S->lock);
+        while (!S->todo && !S->stop)
+            pthread_cond_wait(&S->ready, &S->lock);
+        if (!S->todo)
+        {
+            pthread_mutex_unlock(&S->lock);
+            break;
+        }
+        t = S->todo;
+        S->todo = t->next;
+        pthread_mutex_unlock(&S->lock);
+        if (t->reqs[0]->op == 'C')
+            compileRequest(S, t->reqs[0]);
+        else if (t->reqs[0]->op == 'S')
+            searchRequest(t->reqs[0]);
+        else
+            matchRequests(t);
+        pthread_mutex_lock(&S->lock);
+        t->next = S->done;
+        S->done = t;
+        pthread_mutex_unlock(&S->lock);
+        send(S->wake[1], "", 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+    return NULL;
+}
+
+//Event loop side
+//---------------
+
+static void submit(server *S, request **reqs, int n)
+{
+    task *t = malloc(sizeof(task));
+    t->n = n;
+    t->reqs = malloc(n * sizeof(request *));
+    memcpy(t->reqs, reqs, n * sizeof(request *));
+    t->next = NULL;
+    pthread_mutex_lock(&S->lock);
+    if (S->todo)
+        S->todoTail->next = t;
+    else
+        S->todo = t;
+    S->todoTail = t;
+    pthread_cond_signal(&S->ready);
+    pthread_mutex_unlock(&S->lock);
+}
+
+static int comparePointers(const void *a, const void *b)
+{
+    const void *x = *(void *const *)a, *y = *(void *const *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int compareAutomata(const void *a, const void *b)
+{
+    const request *x = *(request *const *)a, *y = *(request *const *)b;
+    return x->R < y->R ? -1 : x->R > y->R;
+}
+
+// match requests read in one round, grouped by automaton in tasks of
+// up to SERVER_BATCH requests
+static void submitMatches(server *S, request **reqs, int n)
+{
+    int i, j;
+    qsort(reqs, n, sizeof(request *), compareAutomata);
+    for (i = 0; i < n; i = j)
+    {
+        for (j = i + 1; j < n && j - i < SERVER_BATCH && reqs[j]->R == reqs[i]->R; j++)
+            ;
+        submit(S, reqs + i, j - i);
+    }
+}
+
+static void flushConnection(int epoll, connection *c)
+{
+    size_t sent = 0;
+    while (c->head && c->head->done)
+    {
+        request *q = c->head;
+        if (!c->closed)
+            append(&c->out, q->reply.data, q->reply.n);
+        c->head = q->next;
+        free(q->data);
+        free(q->reply.data);
+        free(q);
+    }
+    if (!c->head)
+        c->tail = NULL;
+    while (!c->closed && sent < c->out.n)
+    {
+        ssize_t k = send(c->fd, c->out.data + sent, c->out.n - sent, MSG_NOSIGNAL);
+        if (k <= 0)
+        {
+            if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            c->closed = 1;
+        }
+        else
+            sent += k;
+    }
+    if (sent)
+    {
+        memmove(c->out.data, c->out.data + sent, c->out.n - sent);
+        c->out.n -= sent;
+    }
+    if (!c->closed && !!c->out.n != c->writing)
+    {
+        struct epoll_event ev = {EPOLLIN | (c->out.n ? EPOLLOUT : 0), {.ptr = c}};
+        c->writing = !!c->out.n;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, c->fd, &ev);
+    }
+}
+
+static void closeConnection(int epoll, connection *c)
+{
+    if (c->fd >= 0)
+    {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, c->fd, NULL);
+        close(c->fd);
+        c->fd = -1;
+    }
+    c->closed = 1;
+    if (c->head) // requests in flight: freed when they are done
+        return;
+    free(c->in.data);
+    free(c->out.data);
+    free(c);
+}
+
+// cuts the frames read so far into requests
+static void readRequests(server *S, connection *c, request ***matches, int *nMatches, int *capacity)
+{
+    size_t pos = 0;
+    for (;;)
+    {
+        uint32_t n, id;
+        request *q;
+        if (c->in.n - pos < sizeof(n))
+            break;
+        memcpy(&n, c->in.data + pos, sizeof(n));
+        if (n > SERVER_MAX_FRAME || n < 1)
+        {
+            c->closed = 1;
+            break;
+        }
+        if (c->in.n - pos < sizeof(n) + n)
+            break;
+        q = calloc(1, sizeof(request));
+        q->conn = c;
+        q->op = c->in.data[pos + sizeof(n)];
+        q->size = n - 1;
+        q->data = malloc(q->size + 1);
+        memcpy(q->data, c->in.data + pos + sizeof(n) + 1, q->size);
+        pos += sizeof(n) + n;
+        if (c->tail)
+            c->tail->next = q;
+        else
+            c->head = q;
+        c->tail = q;
+        if (q->op == 'C')
+        {
+            submit(S, &q, 1);
+            continue;
+        }
+        // 'M' and 'S': id of a compiled automaton, then the input
+        if ((q->op == 'M' || q->op == 'S') && q->size >= sizeof(id))
+        {
+            memcpy(&id, q->data, sizeof(id));
+            pthread_mutex_lock(&S->lock);
+            q->R = id < (uint32_t)S->nRegexes ? S->automata[id] : NULL;
+            pthread_mutex_unlock(&S->lock);
+        }
+        if (!q->R)
+        {
+            errorReply(&q->reply, q->op == 'M' || q->op == 'S' ? "unknown automaton" : "unknown request");
+            q->done = 1;
+            continue;
+        }
+        q->size -= sizeof(id);
+        memmove(q->data, q->data + sizeof(id), q->size);
+        if (q->op == 'S')
+            submit(S, &q, 1);
+        else
+        {
+            if (*nMatches == *capacity)
+            {
+                *capacity = *capacity ? 2 * *capacity : 256;
+                *matches = realloc(*matches, *capacity * sizeof(request *));
+            }
+            (*matches)[(*nMatches)++] = q;
+        }
+    }
+    memmove(c->in.data, c->in.data + pos, c->in.n - pos);
+    c->in.n -= pos;
+}
+
+static int listenSocket(char *path)
+{
+    struct sockaddr_un addr;
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0 || strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    remove(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int serveMain(int argc, char **argv)
+{
+    server S;
+    struct epoll_event ev, events[64];
+    pthread_t *threads;
+    request **matches = NULL;
+    connection **conns = NULL;
+    int i, nWorkers = SERVER_WORKERS, capacity = 0, nConns, connCapacity = 0, listener, epoll;
+    if (argc < 3)
+    {
+        printf("\nUsage:%s serve <socket path> [-w workers]\n", argv[0]);
+        printf("\nKeeps compiled automata and answers compile/match/search requests\n");
+        printf("(frames: [length u32][op][payload], see server.h)\n");
+        return 1;
+    }
+    for (i = 3; i < argc; i++)
+        if (!strcmp(argv[i], "-w") && i + 1 < argc && atoi(argv[i + 1]) > 0)
+            nWorkers = atoi(argv[++i]);
+    if ((listener = listenSocket(argv[2])) < 0)
+    {
+        printf("Cannot listen on '%s'!\n", argv[2]);
+        return 1;
+    }
+    memset(&S, 0, sizeof(S));
+    pthread_mutex_init(&S.lock, NULL);
+    pthread_cond_init(&S.ready, NULL);
+    pthread_cond_init(&S.compiled, NULL);
+    S.tableSize = 64;
+    S.table = malloc(S.tableSize * sizeof(int));
+    memset(S.table, -1, S.tableSize * sizeof(int));
+    socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, S.wake);
+    epoll = epoll_create1(0);
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL; // listener
+    epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &ev);
+    ev.data.ptr = &S; // wake up
+    epoll_ctl(epoll, EPOLL_CTL_ADD, S.wake[0], &ev);
+    threads = malloc(nWorkers * sizeof(pthread_t));
+    for (i = 0; i < nWorkers; i++)
+        pthread_create(threads + i, NULL, worker, &S);
+    for (;;)
+    {
+        int n = epoll_wait(epoll, events, 64, -1), nMatches = 0;
+        task *done;
+        for (i = 0; i < n; i++)
+        {
+            connection *c = events[i].data.ptr;
+            if (!events[i].data.ptr)
+            {
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK)) >= 0)
+                {
+                    c = calloc(1, sizeof(connection));
+                    c->fd = fd;
+                    ev.events = EPOLLIN;
+                    ev.data.ptr = c;
+                    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+                }
+            }
+            else if (events[i].data.ptr == &S)
+            {
+                char drain[256];
+                while (recv(S.wake[0], drain, sizeof(drain), 0) > 0)
+                    ;
+            }
+            else
+            {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                {
+                    ssize_t k;
+                    for (;;)
+                    {
+                        reserve(&c->in, 65536);
+                        k = recv(c->fd, c->in.data + c->in.n, c->in.capacity - c->in.n, 0);
+                        if (k <= 0)
+                            break;
+                        c->in.n += k;
+                    }
+                    readRequests(&S, c, &matches, &nMatches, &capacity);
+                    if (k == 0 || (k < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+                        c->closed = 1;
+                }
+                flushConnection(epoll, c);
+                if (c->closed)
+                    closeConnection(epoll, c);
+            }
+        }
+        if (nMatches)
+            submitMatches(&S, matches, nMatches);
+        // finished requests: only marked done here, so a request (and
+        // its connection) stays alive until its task leaves the done list
+        pthread_mutex_lock(&S.lock);
+        done = S.done;
+        S.done = NULL;
+        pthread_mutex_unlock(&S.lock);
+        nConns = 0;
+        while (done)
+        {
+            task *t = done;
+            done = t->next;
+            for (i = 0; i < t->n; i++)
+            {
+                t->reqs[i]->done = 1;
+                if (nConns == connCapacity)
+                {
+                    connCapacity = connCapacity ? 2 * connCapacity : 256;
+                    conns = realloc(conns, connCapacity * sizeof(connection *));
+                }
+                conns[nConns++] = t->reqs[i]->conn;
+            }
+            free(t->reqs);
+            free(t);
+        }
+        if (nConns)
+            qsort(conns, nConns, sizeof(connection *), comparePointers);
+        for (i = 0; i < nConns; i++)
+            if (!i || conns[i] != conns[i - 1])
+            {
+                flushConnection(epoll, conns[i]);
+                if (conns[i]->closed)
+                    closeConnection(epoll, conns[i]);
+            }
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef __SERVER__
+#define __SERVER__
+
+//Server Functions
+//----------------
+//  redfa serve <socket path> [-w workers]
+//
+//  Frames (both ways): [length u32][payload], length = payload bytes,
+//  integers in host byte order (the socket is local)
+//  Requests                        Replies
+//    'C' regex                       'C' id u32
+//    'M' id u32, input               'M' result u8 (1 = full match)
+//    'S' id u32, input               'S' n u32, n x (start u32, length u32)
+//  any request may get               'E' message
+//  Replies come in request order on each connection
+//  Equal regexes get the same id. A compile runs on one worker until it
+//  is done: the subset construction can grow exponentially with the
+//  regex, so -w should leave workers for the matches
+
+#define SERVER_WORKERS 4
+#define SERVER_BATCH 64
+#define SERVER_MAX_FRAME (16 << 20)
+
+int serveMain(int, char **);
+
+#endif
@@ -0,0 +1,108 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHENG_X86
+#endif
+#include "sheng.h"
+#include "table.h"
+
+//Sheng (Shuffle) Table Functions
+//-------------------------------
+//  The mask load does not depend on the state, so the only latency in
+//  the loop is the shuffle (1 cycle) instead of a table load (4+ cycles)
+
+int shengSupported(void)
+{
+#ifdef SHENG_X86
+    return __builtin_cpu_supports("ssse3");
+#else
+    return 0;
+#endif
+}
+
+// NULL if the table has more than 16 states or the cpu has no pshufb
+shengTable *buildShengTable(compactTable *T)
+{
+    shengTable *S;
+    int b, s;
+    if (T->nStates > SHENG_STATES || !shengSupported())
+        return NULL;
+    S = aligned_alloc(CACHE_LINE, (sizeof(shengTable) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    memset(S, 0, sizeof(shengTable));
+    S->nStates = T->nStates;
+    S->initial = T->initial;
+    S->dead = T->dead;
+    for (s = 0; s < T->nStates; s++)
+    {
+        S->accept[s] = T->accept[s];
+        for (b = 0; b < 256; b++)
+            S->masks[b][s] = stateCompactTable(T, s, T->classes[b]);
+    }
+    return S;
+}
+
+#ifdef SHENG_X86
+__attribute__((target("ssse3")))
+static int scanSheng(shengTable *S, const unsigned char *p, size_t n)
+{
+    const __m128i *masks = (const __m128i *)S->masks;
+    __m128i s = _mm_set1_epi8(S->initial);
+    const unsigned char *end;
+    // unrolled: the loads of the masks overlap, the shuffles chain;
+    // the dead state is checked once per block
+    for (; n >= SHENG_BLOCK; n -= SHENG_BLOCK)
+    {
+        for (end = p + SHENG_BLOCK; p < end; p += 4)
+        {
+            s = _mm_shuffle_epi8(_mm_load_si128(masks + p[0]), s);
+            s = _mm_shuffle_epi8(_mm_load_si128(masks + p[1]), s);
+            s = _mm_shuffle_epi8(_mm_load_si128(masks + p[2]), s);
+            s = _mm_shuffle_epi8(_mm_load_si128(masks + p[3]), s);
+        }
+        if ((_mm_cvtsi128_si32(s) & 0xFF) == S->dead)
+            return 0;
+    }
+    while (n--)
+        s = _mm_shuffle_epi8(_mm_load_si128(masks + *p++), s);
+    return S->accept[_mm_cvtsi128_si32(s) & 0xFF];
+}
+#endif
+
+int matchShengTable(shengTable *S, const char *str, size_t n)
+{
+#ifdef SHENG_X86
+    return scanSheng(S, (const unsigned char *)str, n);
+#else
+    // scalar fallback (buildShengTable does not build tables here)
+    const unsigned char *p = (const unsigned char *)str;
+    int s = S->initial;
+    while (n--)
+        s = S->masks[*p++][s];
+    return S->accept[s];
+#endif
+}
+
+void disposeShengTable(shengTable *S)
+{
+    free(S);
+}
@@ -0,0 +1,12 @@
+#ifndef __SHENG__
+#define __SHENG__
+#include "structures.h"
+
+//Sheng (Shuffle) Table Functions
+//-------------------------------
+int shengSupported(void);
+shengTable *buildShengTable(compactTable *);
+int matchShengTable(shengTable *, const char *, size_t);
+void disposeShengTable(shengTable *);
+
+#endif
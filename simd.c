@@ -0,0 +1,85 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+#include "simd.h"
+
+//SIMD Byte Set Functions
+//-----------------------
+//  compare 32 (AVX2) or 16 (SSE2) bytes against up to 4 bytes at once
+//  and take the first position of the movemask; scalar for the tail
+
+// mask of the positions of p equal to any of the bytes (n = 1..4)
+#ifdef __AVX2__
+static unsigned maskByteSet32(const char *p, __m256i *b)
+{
+    __m256i v = _mm256_loadu_si256((const __m256i *)p);
+    __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b[0]), _mm256_cmpeq_epi8(v, b[1])),
+                                 _mm256_or_si256(_mm256_cmpeq_epi8(v, b[2]), _mm256_cmpeq_epi8(v, b[3])));
+    return _mm256_movemask_epi8(eq);
+}
+#endif
+
+#ifdef __SSE2__
+static unsigned maskByteSet16(const char *p, __m128i *b)
+{
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b[0]), _mm_cmpeq_epi8(v, b[1])),
+                              _mm_or_si128(_mm_cmpeq_epi8(v, b[2]), _mm_cmpeq_epi8(v, b[3])));
+    return _mm_movemask_epi8(eq);
+}
+#endif
+
+const char *findByteSet(const char *p, const char *end, const unsigned char *bytes, int n)
+{
+    int i;
+    if (!n)
+        return end;
+#ifdef __AVX2__
+    __m256i b32[4];
+    for (i = 0; i < 4; i++)
+        b32[i] = _mm256_set1_epi8(bytes[i < n ? i : 0]);
+    for (; p + 32 <= end; p += 32)
+    {
+        unsigned mask = maskByteSet32(p, b32);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+#ifdef __SSE2__
+    __m128i b16[4];
+    for (i = 0; i < 4; i++)
+        b16[i] = _mm_set1_epi8(bytes[i < n ? i : 0]);
+    for (; p + 16 <= end; p += 16)
+    {
+        unsigned mask = maskByteSet16(p, b16);
+        if (mask)
+            return p + __builtin_ctz(mask);
+    }
+#endif
+    for (; p < end; p++)
+        for (i = 0; i < n; i++)
+            if (bytes[i] == (unsigned char)*p)
+                return p;
+    return end;
+}
@@ -0,0 +1,9 @@
+#ifndef __SIMD__
+#define __SIMD__
+#include "structures.h"
+
+//SIMD Byte Set Functions
+//-----------------------
+const char *findByteSet(const char *, const char *, const unsigned char *, int);
+
+#endif
@@ -39,6 +39,5 @@ void *pop(stack *T)
         free(n);
         return A;
     }
-    puts("Stack underflow!");
-    exit(1);
+    return NULL; // underflow
 }
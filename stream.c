@@ -0,0 +1,251 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "stream.h"
+#include "table.h"
+
+//Match Stream Functions
+//----------------------
+//  Fragments are scanned in place: the only thing carried from one
+//  fragment to the next is the state, so the result is the same as
+//  for the concatenated input
+
+void initMatchStream(matchStream *st, compactTable *T)
+{
+    st->state = T->initial;
+    st->flags = 0;
+    st->offset = 0;
+    st->matchEnd = 0;
+}
+
+// full match: advances the state over the fragment (a stop state
+// skips the rest of it, as matchCompactTable does)
+#define FEED_LOOP(name, type, op, row)                                                 \
+    static uint32_t name(compactTable *T, uint32_t s, const unsigned char *p,          \
+                         const unsigned char *end)                                     \
+    {                                                                                  \
+        const type *t = T->data;                                                       \
+        const unsigned char *c = T->classes, *block;                                   \
+        accelState *a = T->accel;                                                      \
+        uint32_t k = T->row, next, run = 0;                                            \
+        if (!T->nAccel)                                                                \
+            while (p < end)                                                            \
+            {                                                                          \
+                block = end - p > SCAN_BLOCK ? p + SCAN_BLOCK : end;                   \
+                while (p < block)                                                      \
+                    s = t[(s op k) + c[*p++]];                                         \
+                if (a[s].kind)                                                         \
+                    p = (const unsigned char *)skipAccelState(a + s, c,                \
+                            (const char *)p, (const char *)end);                       \
+            }                                                                          \
+        while (p < end)                                                                \
+        {                                                                              \
+            next = t[(s op k) + c[*p++]];                                              \
+            run = (run + 1) & -(uint32_t)(next == s);                                  \
+            if (run >= ACCEL_RUN && a[s].kind)                                         \
+            {                                                                          \
+                p = (const unsigned char *)skipAccelState(a + s, c, (const char *)p,   \
+                                                          (const char *)end);          \
+                run = 0;                                                               \
+            }                                                                          \
+            s = next;                                                                  \
+        }                                                                              \
+        return s;                                                                      \
+    }
+
+FEED_LOOP(feed8, uint8_t, <<, shift)
+FEED_LOOP(feed16, uint16_t, <<, shift)
+FEED_LOOP(feed32, uint32_t, <<, shift)
+FEED_LOOP(feedExact16, uint16_t, *, stride)
+FEED_LOOP(feedExact32, uint32_t, *, stride)
+
+void feedMatchStream(matchStream *st, compactTable *T, const char *buffer, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)buffer;
+    if (T->shift < 0)
+        st->state = T->width == 2 ? feedExact16(T, st->state, p, p + size) : feedExact32(T, st->state, p, p + size);
+    else
+        switch (T->width)
+        {
+        case 1:
+            st->state = feed8(T, st->state, p, p + size);
+            break;
+        case 2:
+            st->state = feed16(T, st->state, p, p + size);
+            break;
+        default:
+            st->state = feed32(T, st->state, p, p + size);
+        }
+    st->offset += size;
+}
+
+// does the input fed so far match?
+int acceptMatchStream(matchStream *st, compactTable *T)
+{
+    return T->accept[st->state];
+}
+
+// search: the forward table of the searcher stops at the dead state
+// once a match cannot grow, as nextMatch does, and the search goes on
+// from the match end. Only match ends are reported (the start may be in
+// a fragment that is gone), emit finds it in st->matchEnd. p[i..n-1] is
+// scanned, p[0] being at offset base (rescans start after the match end)
+#define STREAM_SEARCH_LOOP(name, type, op, row)                                        \
+    static long name(matchStream *st, compactTable *F, const unsigned char *p,         \
+                     size_t i, size_t n, uint64_t base,                                \
+                     void (*emit)(matchStream *, void *), void *user)                  \
+    {                                                                                  \
+        const type *f = F->data;                                                       \
+        const unsigned char *c = F->classes, *fa = F->accept;                          \
+        accelState *a = F->nAccel ? F->accel : NULL;                                   \
+        uint32_t s = st->state, k = F->row, dead = F->dead, next, run = 0;             \
+        long count = 0;                                                                \
+        for (; i < n; i++)                                                             \
+        {                                                                              \
+            next = f[(s op k) + c[p[i]]];                                              \
+            if (a)                                                                     \
+            {                                                                          \
+                run = (run + 1) & -(uint32_t)(next == s);                              \
+                if (run >= ACCEL_RUN && a[s].kind)                                     \
+                {                                                                      \
+                    i = (const unsigned char *)skipAccelState(a + s, c,                \
+                            (const char *)p + i + 1, (const char *)p + n) - p - 1;     \
+                    run = 0;                                                           \
+                }                                                                      \
+            }                                                                          \
+            s = next;                                                                  \
+            if (fa[s])                                                                 \
+            {                                                                          \
+                st->flags |= STREAM_PENDING;                                           \
+                st->matchEnd = base + i + 1;                                           \
+            }                                                                          \
+            else if (s == dead && (st->flags & STREAM_PENDING))                        \
+            {                                                                          \
+                st->flags = (st->flags & ~STREAM_PENDING) | STREAM_MATCHED;            \
+                s = F->initial;                                                        \
+                i = st->matchEnd - base - 1;                                           \
+                run = 0;                                                               \
+                count++;                                                               \
+                if (emit)                                                              \
+                    emit(st, user);                                                    \
+            }                                                                          \
+        }                                                                              \
+        st->state = s;                                                                 \
+        return count;                                                                  \
+    }
+
+STREAM_SEARCH_LOOP(streamSearch8, uint8_t, <<, shift)
+STREAM_SEARCH_LOOP(streamSearch16, uint16_t, <<, shift)
+STREAM_SEARCH_LOOP(streamSearch32, uint32_t, <<, shift)
+STREAM_SEARCH_LOOP(streamSearchExact16, uint16_t, *, stride)
+STREAM_SEARCH_LOOP(streamSearchExact32, uint32_t, *, stride)
+
+static long searchBytes(searchStream *ss, compactTable *F, const char *buffer, size_t i, size_t n,
+                        uint64_t base, void (*emit)(matchStream *, void *), void *user)
+{
+    const unsigned char *p = (const unsigned char *)buffer;
+    if (F->shift < 0)
+        return F->width == 2 ? streamSearchExact16(&ss->st, F, p, i, n, base, emit, user)
+                             : streamSearchExact32(&ss->st, F, p, i, n, base, emit, user);
+    switch (F->width)
+    {
+    case 1:
+        return streamSearch8(&ss->st, F, p, i, n, base, emit, user);
+    case 2:
+        return streamSearch16(&ss->st, F, p, i, n, base, emit, user);
+    default:
+        return streamSearch32(&ss->st, F, p, i, n, base, emit, user);
+    }
+}
+
+static void reservePending(searchStream *ss, size_t n)
+{
+    if (n <= ss->capacity)
+        return;
+    ss->capacity = ss->capacity ? ss->capacity : 4096;
+    while (n > ss->capacity)
+        ss->capacity *= 2;
+    ss->pending = realloc(ss->pending, ss->capacity);
+}
+
+// keeps the bytes of buffer (at offset base) after the end of a match
+// that may still grow
+static void keepPending(searchStream *ss, const char *buffer, size_t n, uint64_t base)
+{
+    size_t from = ss->st.flags & STREAM_PENDING ? ss->st.matchEnd - base : n;
+    reservePending(ss, n - from);
+    memmove(ss->pending, buffer + from, n - from);
+    ss->nPending = n - from;
+}
+
+void initSearchStream(searchStream *ss, searcher *S)
+{
+    initMatchStream(&ss->st, S->F);
+    ss->pending = NULL;
+    ss->nPending = 0;
+    ss->capacity = 0;
+}
+
+long searchMatchStream(searchStream *ss, searcher *S, const char *buffer, size_t size,
+                       void (*emit)(matchStream *, void *), void *user)
+{
+    uint64_t base = ss->st.offset - ss->nPending;
+    long count;
+    if (ss->nPending)
+    {
+        // the match may still end before this fragment: scanned after
+        // the bytes since its end, so the search can go back there
+        size_t n = ss->nPending;
+        reservePending(ss, n + size);
+        memcpy(ss->pending + n, buffer, size);
+        count = searchBytes(ss, S->F, ss->pending, n, n + size, base, emit, user);
+        keepPending(ss, ss->pending, n + size, base);
+    }
+    else
+    {
+        count = searchBytes(ss, S->F, buffer, 0, size, base, emit, user);
+        keepPending(ss, buffer, size, base);
+    }
+    ss->st.offset += size;
+    return count;
+}
+
+// end of input: a match still growing ends at its last final state, and
+// the bytes after it are searched again
+long finishSearchStream(searchStream *ss, searcher *S, void (*emit)(matchStream *, void *), void *user)
+{
+    long count = 0;
+    while (ss->st.flags & STREAM_PENDING)
+    {
+        uint64_t base = ss->st.matchEnd;
+        ss->st.flags = (ss->st.flags & ~STREAM_PENDING) | STREAM_MATCHED;
+        ss->st.state = S->F->initial;
+        count++;
+        if (emit)
+            emit(&ss->st, user);
+        count += searchBytes(ss, S->F, ss->pending, 0, ss->nPending, base, emit, user);
+        keepPending(ss, ss->pending, ss->nPending, base);
+    }
+    free(ss->pending);
+    ss->pending = NULL;
+    ss->nPending = ss->capacity = 0;
+    return count;
+}
@@ -0,0 +1,14 @@
+#ifndef __STREAM__
+#define __STREAM__
+#include "structures.h"
+
+//Match Stream Functions
+//----------------------
+void initMatchStream(matchStream *, compactTable *);
+void feedMatchStream(matchStream *, compactTable *, const char *, size_t);
+int acceptMatchStream(matchStream *, compactTable *);
+void initSearchStream(searchStream *, searcher *);
+long searchMatchStream(searchStream *, searcher *, const char *, size_t, void (*)(matchStream *, void *), void *);
+long finishSearchStream(searchStream *, searcher *, void (*)(matchStream *, void *), void *);
+
+#endif
@@ -0,0 +1,131 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "stride.h"
+#include "table.h"
+
+//Two Stride Table Functions
+//--------------------------
+//  The alphabet is the pairs of byte classes: one dependent load per
+//  two input bytes (the class lookups do not depend on the state)
+
+// NULL if the pair table would be larger than maxSize bytes
+strideTable *buildStrideTable(compactTable *T, size_t maxSize)
+{
+    strideTable *S;
+    size_t size;
+    int s, a, b, shift;
+    for (shift = 0; (1 << shift) < T->nClasses; shift++)
+        ;
+    size = ((size_t)T->nStates << 2 * shift) * T->width;
+    if (size > maxSize)
+        return NULL;
+    S = malloc(sizeof(strideTable));
+    S->width = T->width;
+    S->nStates = T->nStates;
+    S->shift = shift;
+    S->initial = T->initial;
+    S->dead = T->dead;
+    memcpy(S->classes, T->classes, sizeof(S->classes));
+    S->accept = malloc(T->nStates);
+    memcpy(S->accept, T->accept, T->nStates);
+    S->T = T;
+    S->data = aligned_alloc(CACHE_LINE, (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    memset(S->data, 0, size);
+    for (s = 0; s < T->nStates; s++)
+        for (a = 0; a < T->nClasses; a++)
+        {
+            int t = stateCompactTable(T, s, a);
+            for (b = 0; b < T->nClasses; b++)
+            {
+                size_t pos = ((size_t)s << 2 * S->shift) | a << S->shift | b;
+                int next = stateCompactTable(T, t, b);
+                switch (S->width)
+                {
+                case 1:
+                    ((uint8_t *)S->data)[pos] = next;
+                    break;
+                case 2:
+                    ((uint16_t *)S->data)[pos] = next;
+                    break;
+                default:
+                    ((uint32_t *)S->data)[pos] = next;
+                }
+            }
+        }
+    return S;
+}
+
+#define STRIDE_LOOP(name, type)                                            \
+    static int name(strideTable *S, const unsigned char *p, size_t n)      \
+    {                                                                      \
+        const type *t = S->data;                                           \
+        const unsigned char *c = S->classes, *end = p + (n & ~(size_t)1);  \
+        const unsigned char *block;                                        \
+        int shift = S->shift, shift2 = 2 * S->shift;                       \
+        uint32_t s = S->initial, dead = S->dead;                           \
+        while (p < end)                                                    \
+        {                                                                  \
+            block = end - p > STRIDE_BLOCK ? p + STRIDE_BLOCK : end;       \
+            for (; p < block; p += 2)                                      \
+                s = t[(s << shift2) | c[p[0]] << shift | c[p[1]]];         \
+            if (s == dead) /* rejects every continuation */                \
+                return 0;                                                  \
+        }                                                                  \
+        if (n & 1)                                                         \
+            s = stateCompactTable(S->T, s, c[*p]);                         \
+        return S->accept[s];                                               \
+    }
+
+STRIDE_LOOP(stride8, uint8_t)
+STRIDE_LOOP(stride16, uint16_t)
+STRIDE_LOOP(stride32, uint32_t)
+
+int matchStrideTable(strideTable *S, const char *str, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    switch (S->width)
+    {
+    case 1:
+        return stride8(S, p, n);
+    case 2:
+        return stride16(S, p, n);
+    default:
+        return stride32(S, p, n);
+    }
+}
+
+void displayStrideTable(strideTable *S)
+{
+    printf("\nTwo stride table\n");
+    printf("----------------\n");
+    printf("nStates  = %d\n", S->nStates);
+    printf("pairs    = %d (stride = %d)\n", S->T->nClasses * S->T->nClasses, 1 << 2 * S->shift);
+    printf("size     = %lu bytes\n", (unsigned long)((size_t)S->nStates << 2 * S->shift) * S->width);
+}
+
+void disposeStrideTable(strideTable *S)
+{
+    if (!S) return;
+    free(S->accept);
+    free(S->data);
+    free(S);
+}
@@ -0,0 +1,12 @@
+#ifndef __STRIDE__
+#define __STRIDE__
+#include "structures.h"
+
+//Two Stride Table Functions
+//--------------------------
+strideTable *buildStrideTable(compactTable *, size_t);
+int matchStrideTable(strideTable *, const char *, size_t);
+void displayStrideTable(strideTable *);
+void disposeStrideTable(strideTable *);
+
+#endif
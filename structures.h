@@ -5,8 +5,16 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #define EPSILON '-'
+
+// regex errors (convert, parseRegex)
+#define PARSE_OK 0
+#define PARSE_SYMBOL 1
+#define PARSE_PARENTHESIS 2
+#define PARSE_OPERAND 3
 #define DEBUG(x)
 
 //Stack Pointer Structure
@@ -54,12 +62,55 @@ typedef struct
 } nfa;
 
 
+//Regex AST Structure (hash consed)
+//---------------------------------
+//  astNode: [op|id|refs|left|right|fragment|next]
+//    op = symbol, '*' (left only), '.' or '|'
+//    refs = parents (and roots) using the node: fragment (the nfa of
+//           the subtree) is kept only when refs > 1
+//  astTable: buckets[hash(op, left, right)] -> node -> node ...
+//    one node per distinct subtree, so equal subtrees are the same node
+
+typedef struct astNode
+{
+    char op;
+    int id;
+    int refs;
+    struct astNode *left;
+    struct astNode *right;
+    nfa *fragment;
+    struct astNode *next;
+} astNode;
+
+typedef struct astTable
+{
+    int nNodes;
+    int nBuckets;
+    astNode **buckets;
+    long shared; // nodes found already interned
+} astTable;
+
+
 // Dfa state structure
 //--------------------
+//  kind (set by classifyDfa on minimized dfas, LIVE elsewhere):
+//    STATE_LIVE -> may still accept or reject
+//    STATE_DEAD -> no path to a final state (rejects every continuation)
+//    STATE_SINK -> final, every path stays final (accepts every continuation)
+
+#define STATE_LIVE 0
+#define STATE_DEAD 1
+#define STATE_SINK 2
+
+// product operations (productDfa)
+#define PRODUCT_INTERSECTION 0 // accepted by A and B
+#define PRODUCT_DIFFERENCE 1   // accepted by A, not by B
+
 typedef struct dfaState
 {
     int final;
     int initial;
+    int kind;
     set *stateSet;
     struct dfaState *next;
 } dfaState;
@@ -90,4 +141,302 @@ typedef struct dfa
     int *transitions;
 } dfa;
 
+
+//DFA Pair Operand Structure
+//--------------------------
+//  one of two dfas run together (product, equivalence) over a common
+//  vocabulary; a symbol outside its own sigma goes to an extra dead
+//  state n of it
+//  final[n + 1], kind[n + 1] -> of each state (n: 0, STATE_DEAD)
+//  column[c] -> column of symbol c of the common vocabulary (-1 = not
+//               in sigma), complete -> every symbol is in sigma
+
+typedef struct pairOperand
+{
+    dfa *D;
+    int n;
+    int initial;
+    char *final;
+    char *kind;
+    int *column;
+    int complete;
+} pairOperand;
+
+
+//Compact Transition Table Structure
+//----------------------------------
+//  [ ] width (1, 2 or 4 bytes per state id, chosen by nStates)
+//  [ ] nStates (dfa states, plus a dead state when the dfa has none)
+//  [ ] nClasses (class 0 = bytes outside sigma, class i+1 = sigma[i])
+//  [ ] stride (entries per row), shift (log2 of stride, -1 if exact)
+//  classes[256] -> byte to class map
+//  accept[nStates] -> 1 if state is final
+//  data (state * stride + class), 64 byte aligned:
+//  -----------------------------------------------
+//               0   1   2  .... nClasses-1 (padding)
+//             +---+---+---------+---+-----
+//           0 | x   x             x
+//     (...)
+//   nStates-1 | x   x             x
+//  With a power of two stride and an aligned base a row never
+//  crosses a cache line (or starts one when larger than a line).
+//  One byte tables are always padded, wider ones only while that
+//  wastes at most half a row and keeps them no larger than an int
+//  table, else stride = nClasses and the scans multiply (exact)
+//  accel[nStates] -> live states left only by a few bytes (ACCEL_EXIT),
+//  skipped with SIMD (nAccel > 0) once ACCEL_RUN bytes in a row have
+//  looped on them, so short runs never pay for a SIMD call. States left
+//  by no byte (the dead state, or an accept sink when the vocabulary has
+//  every byte) stop the scan (ACCEL_STOP); states left only by bytes
+//  outside the vocabulary (accept sinks) skip to the next such byte
+//  (ACCEL_SINK). Neither is counted in nAccel: without ACCEL_EXIT states
+//  the full match scans check them once per SCAN_BLOCK bytes
+
+#define CACHE_LINE 64
+
+#define ACCEL_NONE 0
+#define ACCEL_EXIT 1
+#define ACCEL_STOP 2
+#define ACCEL_SINK 3
+#define ACCEL_BYTES 4
+#define ACCEL_RUN 2
+#define SCAN_BLOCK 64
+
+typedef struct accelState
+{
+    unsigned char kind;
+    unsigned char n;
+    unsigned char bytes[ACCEL_BYTES];
+} accelState;
+
+typedef struct compactTable
+{
+    int width;
+    int nStates;
+    int nClasses;
+    int stride;
+    int shift;
+    int initial;
+    int dead;
+    unsigned char classes[256];
+    unsigned char *accept;
+    int nAccel;
+    accelState *accel;
+    void *data;
+} compactTable;
+
+// streams scanned in lockstep by matchCompactTableBatch, and bytes
+// between checks for finished or stopped streams
+#define BATCH_STREAMS 8
+#define BATCH_BLOCK 64
+
+
+//Comb (Row Displacement) Table Structure
+//---------------------------------------
+//  [ ] nStates, nClasses, initial, dead (as in compactTable)
+//  [ ] size (entries of next/check)
+//  base[nStates] -> row offset in next/check (equal rows share it)
+//  def[nStates]  -> most frequent target of the row
+//  next/check: a row keeps only entries different from def,
+//  packed (comb) over the holes of the other rows
+//  -----------------------------------------------
+//     delta(s, c) = check[base[s] + c] == base[s] ?
+//                   next[base[s] + c] : def[s]
+
+typedef struct combTable
+{
+    int nStates;
+    int nClasses;
+    int initial;
+    int dead;
+    int size;
+    unsigned char classes[256];
+    unsigned char *accept;
+    int *base;
+    int *def;
+    int *next;
+    int *check;
+} combTable;
+
+
+//Sheng (Shuffle) Table Structure
+//-------------------------------
+//  for automata with up to 16 states (dead state included)
+//  masks[b][s] = next state of s on byte b, 16 bytes per input byte
+//  the state is kept in a vector register (every lane = state) and
+//  one pshufb(masks[b], state) per input byte gives the next state
+//  dead -> checked once per SHENG_BLOCK bytes to stop the scan
+
+#define SHENG_STATES 16
+#define SHENG_BLOCK 16
+
+typedef struct shengTable
+{
+    unsigned char masks[256][SHENG_STATES];
+    unsigned char accept[SHENG_STATES];
+    int nStates;
+    int initial;
+    int dead;
+} shengTable;
+
+
+//Two Stride Table Structure
+//--------------------------
+//  [ ] width, nStates, initial, dead, classes[256], accept (as in compactTable)
+//  [ ] shift (log2 of nClasses of T rounded up, rows have 1 << 2*shift entries)
+//  data[s << 2*shift | c(b0) << shift | c(b1)] = state after bytes b0 b1
+//  T -> one byte table for the last byte of odd lengths (not owned)
+//  dead -> checked once per STRIDE_BLOCK bytes to stop the scan
+
+#define STRIDE_MAX_SIZE (256 * 1024)
+#define STRIDE_BLOCK 64
+
+typedef struct strideTable
+{
+    int width;
+    int nStates;
+    int shift;
+    int initial;
+    int dead;
+    unsigned char classes[256];
+    unsigned char *accept;
+    compactTable *T;
+    void *data;
+} strideTable;
+
+
+//Lexer Structure
+//---------------
+//  [ ] nRules (ordered token rules, lower index = higher priority)
+//  [ ] maxLookahead (bytes scanned past the last accept, 0 = unbounded)
+//  D -> minimized dfa of the union of the rules
+//  T -> compact table of D
+//  rule[T->nStates] -> rule accepted in each state or -1
+//  token = [rule|offset|length], rule -1 = byte matched by no rule
+
+typedef struct lexer
+{
+    int nRules;
+    size_t maxLookahead;
+    dfa *D;
+    compactTable *T;
+    int *rule;
+} lexer;
+
+typedef struct token
+{
+    int rule;
+    size_t offset;
+    size_t length;
+} token;
+
+
+//Searcher Structure
+//------------------
+//  F -> forward dfa of (sigma*)R without the empty string: it accepts
+//       from the earliest match end (bytes outside sigma restart) and
+//       stops growing the match (dead state) when no match started
+//       before that end can go on: the last final state is its end
+//  R -> dfa of reverse(R), run backwards from that end to the leftmost
+//       start of a match ending there
+//  both tables have the same width
+
+typedef struct searcher
+{
+    compactTable *F;
+    compactTable *R;
+} searcher;
+
+
+//Match Stream Structure
+//----------------------
+//  state of one input fed in fragments to a compact table (the table is
+//  passed to every call, so a stream is 24 bytes)
+//  [state|flags|offset|matchEnd]
+//  offset   -> bytes fed so far
+//  matchEnd -> end offset of the last match found (flags & STREAM_MATCHED),
+//              or of the match still growing (flags & STREAM_PENDING)
+//  searchStream -> matchStream of a search and the bytes fed since the
+//  end of a match still growing (pending), searched again from that end
+//  once the match cannot grow
+
+#define STREAM_MATCHED 1
+#define STREAM_PENDING 2
+
+typedef struct matchStream
+{
+    uint32_t state;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t matchEnd;
+} matchStream;
+
+typedef struct searchStream
+{
+    matchStream st;
+    char *pending;
+    size_t nPending;
+    size_t capacity;
+} searchStream;
+
+
+//Chunk Reader Structure
+//----------------------
+//  a reader thread fills a ring of nBuffers aligned buffers while the
+//  scanning thread consumes them in order
+//                 tail (next to fill)
+//                   v
+//  +-----+-----+-----+-----+
+//  | ful | ful |     |     |  buffers[nBuffers], lengths[nBuffers]
+//  +-----+-----+-----+-----+
+//     ^ head (next to scan), count = filled buffers
+//  eof -> the file is exhausted (error -> by a read error),
+//  stop -> the reader must quit
+
+#define READER_BUFFERS 4
+#define READER_SIZE (1 << 20)
+#define READER_ALIGN 4096
+
+typedef struct chunkReader
+{
+    FILE *file;
+    int nBuffers;
+    size_t size;
+    char **buffers;
+    size_t *lengths;
+    int head;
+    int tail;
+    int count;
+    int eof;
+    int error;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t filled;
+    pthread_cond_t emptied;
+    pthread_t thread;
+} chunkReader;
+
+
+//Prefilter Structure
+//-------------------
+//  [ ] nLiterals (every match contains at least one of the literals)
+//  literals[nLiterals] -> required literal factors of the regex
+//  one literal: vectorized memmem
+//  more literals: Aho-Corasick automaton
+//      ac[acStates * 256] -> goto/fail transitions as a full table
+//      acFinal[acStates]  -> 1 if a literal ends in the state
+//      first[nFirst] -> first bytes of the literals (nFirst = 0 if > 4),
+//                       skipped to with SIMD while in the root state
+
+typedef struct prefilter
+{
+    int nLiterals;
+    char **literals;
+    int acStates;
+    int *ac;
+    unsigned char *acFinal;
+    int nFirst;
+    unsigned char first[4];
+} prefilter;
+
 #endif
\ No newline at end of file
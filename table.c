@@ -0,0 +1,450 @@
+/*-----------------------------------------------------------------------
+ * redfa - Converts Regex to minimized deterministic finite automata
+ * Using | to union, . (not digited) to concat and * to kleene closure
+ * By Luiz Eduardo da Silva - 2019
+ *
+ * This file is part of redfa.
+ *
+ * redfa is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * redfa is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with redfa.  If not, see <https://www.gnu.org/licenses/>
+ *-----------------------------------------------------------------------*/
+
+#include "table.h"
+#include "dfa.h"
+#include "simd.h"
+
+//Compact Transition Table Functions
+//----------------------------------
+
+void setCompactTable(compactTable *T, int state, int class, int next)
+{
+    size_t pos = (size_t)state * T->stride + class;
+    switch (T->width)
+    {
+    case 1:
+        ((uint8_t *)T->data)[pos] = next;
+        break;
+    case 2:
+        ((uint16_t *)T->data)[pos] = next;
+        break;
+    default:
+        ((uint32_t *)T->data)[pos] = next;
+    }
+}
+
+int stateCompactTable(compactTable *T, int state, int class)
+{
+    size_t pos = (size_t)state * T->stride + class;
+    switch (T->width)
+    {
+    case 1:
+        return ((uint8_t *)T->data)[pos];
+    case 2:
+        return ((uint16_t *)T->data)[pos];
+    default:
+        return ((uint32_t *)T->data)[pos];
+    }
+}
+
+compactTable *buildCompactTable(dfa *D)
+{
+    return buildCompactTableWidth(D, 1);
+}
+
+// width = minimum bytes per state id
+compactTable *buildCompactTableWidth(dfa *D, int width)
+{
+    compactTable *T = malloc(sizeof(compactTable));
+    dfaState *st;
+    size_t size;
+    int i, j;
+    T->dead = deadState(D);
+    T->nStates = D->nStates + (T->dead < 0);
+    if (T->dead < 0)
+        T->dead = D->nStates;
+    T->nClasses = D->nSymbols + 1;
+    T->initial = initialState(D);
+    if (T->nStates <= UINT8_MAX + 1 && width <= 1)
+        T->width = 1;
+    else if (T->nStates <= UINT16_MAX + 1 && width <= 2)
+        T->width = 2;
+    else
+        T->width = 4;
+    for (T->shift = 0; (1 << T->shift) < T->nClasses; T->shift++)
+        ;
+    T->stride = 1 << T->shift;
+    if (T->width > 1 && (2 * T->stride > 3 * T->nClasses || T->stride * T->width > T->nClasses * (int)sizeof(int)))
+    {
+        T->stride = T->nClasses;
+        T->shift = -1;
+    }
+    size = (size_t)T->nStates * T->stride * T->width;
+    size = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    T->data = aligned_alloc(CACHE_LINE, size);
+    memset(T->data, 0, size);
+    memset(T->classes, 0, sizeof(T->classes));
+    for (j = 0; j < D->nSymbols; j++)
+        T->classes[(unsigned char)D->sigma[j]] = j + 1;
+    T->accept = calloc(T->nStates, sizeof(unsigned char));
+    for (i = 0, st = D->states; st; i++, st = st->next)
+        T->accept[i] = st->final;
+    for (i = 0; i < T->nStates; i++)
+    {
+        setCompactTable(T, i, 0, T->dead);
+        for (j = 0; j < D->nSymbols; j++)
+            setCompactTable(T, i, j + 1, i < D->nStates ? D->transitions[i * D->nSymbols + j] : T->dead);
+    }
+    T->accel = NULL;
+    accelerateCompactTable(T);
+    return T;
+}
+
+// Moves the rows to the exact stride (nClasses), in place
+void unpadCompactTable(compactTable *T)
+{
+    int i;
+    if (T->shift < 0)
+        return;
+    for (i = 0; i < T->nStates; i++)
+        memmove((char *)T->data + (size_t)i * T->nClasses * T->width,
+                (char *)T->data + (size_t)i * T->stride * T->width, (size_t)T->nClasses * T->width);
+    T->stride = T->nClasses;
+    T->shift = -1;
+}
+
+// Finds the states left by at most ACCEL_BYTES bytes: they keep the
+// state on long runs of any other byte. States left by no byte stop
+// the scan and states left only by bytes outside the vocabulary skip
+// to the next such byte (must be called again if the table is changed)
+void accelerateCompactTable(compactTable *T)
+{
+    int i, b;
+    free(T->accel);
+    T->accel = calloc(T->nStates, sizeof(accelState));
+    T->nAccel = 0;
+    for (i = 0; i < T->nStates; i++)
+    {
+        accelState exit = {ACCEL_EXIT, 0, {0}};
+        int sink = 1;
+        for (b = 0; b < 256; b++)
+            if (stateCompactTable(T, i, T->classes[b]) != i)
+            {
+                if (exit.n < ACCEL_BYTES)
+                    exit.bytes[exit.n] = b;
+                if (exit.n <= ACCEL_BYTES)
+                    exit.n++;
+                sink &= !T->classes[b];
+            }
+        if (!exit.n)
+            T->accel[i].kind = ACCEL_STOP;
+        else if (exit.n <= ACCEL_BYTES)
+        {
+            T->accel[i] = exit;
+            T->nAccel++;
+        }
+        else if (sink)
+            T->accel[i].kind = ACCEL_SINK;
+    }
+}
+
+// first position where state s may change (end for a stop state)
+const char *skipAccelState(accelState *a, const unsigned char *classes, const char *p, const char *end)
+{
+    if (a->kind == ACCEL_SINK)
+    {
+        while (p < end && classes[(unsigned char)*p])
+            p++;
+        return p;
+    }
+    return findByteSet(p, end, a->bytes, a->n);
+}
+
+// Width specialized scan loops: one dependent load per input byte. After
+// ACCEL_RUN self loops on an accelerated state the loop jumps to the next
+// byte leaving it. Without ACCEL_EXIT states the stop and sink states
+// are checked once per SCAN_BLOCK bytes. The row of s is s << shift, or
+// s * stride for exact strides (op, row)
+#define SCAN_LOOP(name, type, op, row)                                     \
+    static int name(compactTable *T, const unsigned char *p, size_t n)     \
+    {                                                                      \
+        const type *t = T->data;                                           \
+        const unsigned char *c = T->classes, *end = p + n, *block;         \
+        accelState *a = T->accel;                                          \
+        uint32_t s = T->initial, k = T->row, next, run = 0;                \
+        if (!T->nAccel)                                                    \
+            while (p < end)                                                \
+            {                                                              \
+                block = end - p > SCAN_BLOCK ? p + SCAN_BLOCK : end;       \
+                while (p < block)                                          \
+                    s = t[(s op k) + c[*p++]];                             \
+                if (a[s].kind)                                             \
+                    p = (const unsigned char *)skipAccelState(a + s, c,    \
+                            (const char *)p, (const char *)end);           \
+            }                                                              \
+        while (p < end)                                                    \
+        {                                                                  \
+            next = t[(s op k) + c[*p++]];                                  \
+            run = (run + 1) & -(uint32_t)(next == s); /* no branch */      \
+            if (run >= ACCEL_RUN && a[s].kind)                             \
+            {                                                              \
+                p = (const unsigned char *)skipAccelState(a + s, c,        \
+                        (const char *)p, (const char *)end);               \
+                run = 0;                                                   \
+            }                                                              \
+            s = next;                                                      \
+        }                                                                  \
+        return T->accept[s];                                               \
+    }
+
+SCAN_LOOP(scan8, uint8_t, <<, shift)
+SCAN_LOOP(scan16, uint16_t, <<, shift)
+SCAN_LOOP(scan32, uint32_t, <<, shift)
+SCAN_LOOP(scanExact16, uint16_t, *, stride)
+SCAN_LOOP(scanExact32, uint32_t, *, stride)
+
+int matchCompactTable(compactTable *T, const char *str, size_t n)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    if (T->shift < 0)
+        return T->width == 2 ? scanExact16(T, p, n) : scanExact32(T, p, n);
+    switch (T->width)
+    {
+    case 1:
+        return scan8(T, p, n);
+    case 2:
+        return scan16(T, p, n);
+    default:
+        return scan32(T, p, n);
+    }
+}
+
+// Batch scan: up to BATCH_STREAMS streams advance in lockstep, so the
+// transition loads of different streams overlap instead of waiting on
+// each other. A finished stream (or one in a stop state, checked
+// every BATCH_BLOCK bytes) is replaced by the next one.
+// The streams go in groups of 8 (then 4, then 1) whose states are
+// locals: the compiler keeps them in registers and issues their loads
+// back to back, which it cannot do through arrays indexed at run time
+#define BATCH_LANES8(op, j)                                                                 \
+    {                                                                                       \
+        const unsigned char *p0 = p[j], *p1 = p[j + 1], *p2 = p[j + 2], *p3 = p[j + 3];     \
+        const unsigned char *p4 = p[j + 4], *p5 = p[j + 5], *p6 = p[j + 6], *p7 = p[j + 7]; \
+        uint32_t s0 = s[j], s1 = s[j + 1], s2 = s[j + 2], s3 = s[j + 3];                    \
+        uint32_t s4 = s[j + 4], s5 = s[j + 5], s6 = s[j + 6], s7 = s[j + 7];                \
+        for (i = 0; i < m; i++)                                                             \
+        {                                                                                   \
+            s0 = t[(s0 op r) + c[p0[i]]];                                                   \
+            s1 = t[(s1 op r) + c[p1[i]]];                                                   \
+            s2 = t[(s2 op r) + c[p2[i]]];                                                   \
+            s3 = t[(s3 op r) + c[p3[i]]];                                                   \
+            s4 = t[(s4 op r) + c[p4[i]]];                                                   \
+            s5 = t[(s5 op r) + c[p5[i]]];                                                   \
+            s6 = t[(s6 op r) + c[p6[i]]];                                                   \
+            s7 = t[(s7 op r) + c[p7[i]]];                                                   \
+        }                                                                                   \
+        s[j] = s0, s[j + 1] = s1, s[j + 2] = s2, s[j + 3] = s3;                             \
+        s[j + 4] = s4, s[j + 5] = s5, s[j + 6] = s6, s[j + 7] = s7;                         \
+    }
+
+#define BATCH_LANES4(op, j)                                                                 \
+    {                                                                                       \
+        const unsigned char *p0 = p[j], *p1 = p[j + 1], *p2 = p[j + 2], *p3 = p[j + 3];     \
+        uint32_t s0 = s[j], s1 = s[j + 1], s2 = s[j + 2], s3 = s[j + 3];                    \
+        for (i = 0; i < m; i++)                                                             \
+        {                                                                                   \
+            s0 = t[(s0 op r) + c[p0[i]]];                                                   \
+            s1 = t[(s1 op r) + c[p1[i]]];                                                   \
+            s2 = t[(s2 op r) + c[p2[i]]];                                                   \
+            s3 = t[(s3 op r) + c[p3[i]]];                                                   \
+        }                                                                                   \
+        s[j] = s0, s[j + 1] = s1, s[j + 2] = s2, s[j + 3] = s3;                             \
+    }
+
+#define BATCH_LANES1(op, j)                                                                 \
+    {                                                                                       \
+        const unsigned char *p0 = p[j];                                                     \
+        uint32_t s0 = s[j];                                                                 \
+        for (i = 0; i < m; i++)                                                             \
+            s0 = t[(s0 op r) + c[p0[i]]];                                                   \
+        s[j] = s0;                                                                          \
+    }
+
+#define BATCH_LOOP(name, type, op, row)                                                     \
+    static void name(compactTable *T, const char **strs, const size_t *lens, int n,        \
+                     int *results)                                                          \
+    {                                                                                       \
+        const type *t = T->data;                                                            \
+        const unsigned char *c = T->classes, *p[BATCH_STREAMS];                             \
+        uint32_t s[BATCH_STREAMS];                                                          \
+        size_t left[BATCH_STREAMS], m, i;                                                   \
+        uint32_t r = T->row;                                                                \
+        int id[BATCH_STREAMS], k = 0, next = 0, j;                                          \
+        for (;;)                                                                            \
+        {                                                                                   \
+            for (; k < BATCH_STREAMS && next < n; k++, next++)                              \
+            {                                                                               \
+                p[k] = (const unsigned char *)strs[next];                                   \
+                left[k] = lens[next];                                                       \
+                s[k] = T->initial;                                                          \
+                id[k] = next;                                                               \
+            }                                                                               \
+            if (!k)                                                                         \
+                break;                                                                      \
+            for (m = BATCH_BLOCK, j = 0; j < k; j++)                                        \
+                if (left[j] < m)                                                            \
+                    m = left[j];                                                            \
+            for (j = 0; j + 8 <= k; j += 8)                                                 \
+                BATCH_LANES8(op, j)                                                         \
+            for (; j + 4 <= k; j += 4)                                                      \
+                BATCH_LANES4(op, j)                                                         \
+            for (; j < k; j++)                                                              \
+                BATCH_LANES1(op, j)                                                         \
+            for (j = k - 1; j >= 0; j--)                                                    \
+            {                                                                               \
+                p[j] += m;                                                                  \
+                left[j] -= m;                                                               \
+                if (left[j] && T->accel[s[j]].kind != ACCEL_STOP)                           \
+                    continue;                                                               \
+                results[id[j]] = T->accept[s[j]];                                           \
+                k--;                                                                        \
+                p[j] = p[k];                                                                \
+                left[j] = left[k];                                                          \
+                s[j] = s[k];                                                                \
+                id[j] = id[k];                                                              \
+            }                                                                               \
+        }                                                                                   \
+    }
+
+BATCH_LOOP(batch8, uint8_t, <<, shift)
+BATCH_LOOP(batch16, uint16_t, <<, shift)
+BATCH_LOOP(batch32, uint32_t, <<, shift)
+BATCH_LOOP(batchExact16, uint16_t, *, stride)
+BATCH_LOOP(batchExact32, uint32_t, *, stride)
+
+// results[i] = full match of strs[i] (lens[i] bytes), for n streams
+void matchCompactTableBatch(compactTable *T, const char **strs, const size_t *lens, int n, int *results)
+{
+    if (T->shift < 0)
+    {
+        if (T->width == 2)
+            batchExact16(T, strs, lens, n, results);
+        else
+            batchExact32(T, strs, lens, n, results);
+        return;
+    }
+    switch (T->width)
+    {
+    case 1:
+        batch8(T, strs, lens, n, results);
+        break;
+    case 2:
+        batch16(T, strs, lens, n, results);
+        break;
+    default:
+        batch32(T, strs, lens, n, results);
+    }
+}
+
+// Profiling scan: visits[s] += bytes read in state s and
+// counts[s * stride + class] += transitions taken (no acceleration)
+int profileCompactTable(compactTable *T, const char *str, size_t n, long *visits, long *counts)
+{
+    const unsigned char *p = (const unsigned char *)str;
+    int s = T->initial;
+    while (n--)
+    {
+        int class = T->classes[*p++];
+        visits[s]++;
+        counts[(size_t)s * T->stride + class]++;
+        s = stateCompactTable(T, s, class);
+    }
+    return T->accept[s];
+}
+
+void displayProfile(compactTable *T, long *visits, long *counts)
+{
+    long total = 0;
+    int i, j;
+    for (i = 0; i < T->nStates; i++)
+        total += visits[i];
+    printf("\nProfile (%ld bytes)\n", total);
+    printf("-------\n");
+    printf("state    visits      %%  transitions (byte:count)\n");
+    for (i = 0; i < T->nStates; i++)
+    {
+        printf("%5d%c %9ld %6.2f ", i, T->accept[i] ? '*' : ' ', visits[i], total ? 100.0 * visits[i] / total : 0.0);
+        for (j = 0; j < T->nClasses; j++)
+        {
+            long c = counts[(size_t)i * T->stride + j];
+            int b;
+            if (!c)
+                continue;
+            for (b = 0; j && T->classes[b] != j; b++)
+                ;
+            if (j)
+                printf(" %c:%ld", b, c);
+            else
+                printf(" ?:%ld", c);
+        }
+        printf("\n");
+    }
+}
+
+void displayCompactTable(compactTable *T)
+{
+    int i, j;
+    size_t size = (size_t)T->nStates * T->stride * T->width;
+    printf("\nCompact table\n");
+    printf("-------------\n");
+    printf("width    = %d byte(s)\n", T->width);
+    printf("nStates  = %d (dead = %d)\n", T->nStates, T->dead);
+    printf("nClasses = %d (stride = %d%s)\n", T->nClasses, T->stride, T->shift < 0 ? ", exact" : "");
+    printf("size     = %lu bytes (int table = %lu bytes)\n", (unsigned long)size,
+           (unsigned long)T->nStates * T->nClasses * sizeof(int));
+    printf("nAccel   = %d\n", T->nAccel);
+    printf("Transitions:\n");
+    printf("%4c %4s", ' ', "?");
+    for (i = 0; i < 256; i++)
+        if (T->classes[i])
+            printf("%4c", i);
+    printf("\n");
+    for (i = 0; i < T->nStates; i++)
+    {
+        printf("%3d%c:", i, T->accept[i] ? '*' : ' ');
+        printf("%4d", stateCompactTable(T, i, 0));
+        for (j = 0; j < 256; j++)
+            if (T->classes[j])
+                printf("%4d", stateCompactTable(T, i, T->classes[j]));
+        if (T->accel[i].kind == ACCEL_STOP)
+            printf("  stop");
+        else if (T->accel[i].kind == ACCEL_SINK)
+            printf("  sink");
+        else if (T->accel[i].kind)
+        {
+            printf("  exit {");
+            for (j = 0; j < T->accel[i].n; j++)
+                printf(isgraph(T->accel[i].bytes[j]) ? "%s%c" : "%s\\x%02x", j ? "," : "", T->accel[i].bytes[j]);
+            printf("}");
+        }
+        printf("\n");
+    }
+}
+
+void disposeCompactTable(compactTable *T)
+{
+    if (!T) return;
+    free(T->accept);
+    free(T->accel);
+    free(T->data);
+    free(T);
+}
@@ -0,0 +1,21 @@
+#ifndef __TABLE__
+#define __TABLE__
+#include "structures.h"
+
+//Compact Transition Table Functions
+//----------------------------------
+compactTable *buildCompactTable(dfa *);
+compactTable *buildCompactTableWidth(dfa *, int);
+void setCompactTable(compactTable *, int, int, int);
+void unpadCompactTable(compactTable *);
+void accelerateCompactTable(compactTable *);
+const char *skipAccelState(accelState *, const unsigned char *, const char *, const char *);
+int stateCompactTable(compactTable *, int, int);
+int matchCompactTable(compactTable *, const char *, size_t);
+void matchCompactTableBatch(compactTable *, const char **, const size_t *, int, int *);
+int profileCompactTable(compactTable *, const char *, size_t, long *, long *);
+void displayProfile(compactTable *, long *, long *);
+void displayCompactTable(compactTable *);
+void disposeCompactTable(compactTable *);
+
+#endif